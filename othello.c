@@ -2,12 +2,60 @@
  *
  * This program implements the game of othello, using the minimax algorithm
  * (with alpha-beta pruning) to choose the computer's moves.
- * The "verbose" option is useful for quickly debugging program semantics.
+ * The "verbose" option is useful for quickly debugging program semantics;
+ * it traces the search only in a build compiled with -DTRACE.
+ * A build compiled with -DPROFILE (make profile) reports at exit where
+ * the search spent its time (see profile_report()).
  * (H)elp and (Q)uit are available at the command line.
- * The best_move() function returns a linked list of best move records,
- * to the depth specified by max_ply.  An application heap (manifested as
- * a linked list) stores allocated but currently unused move records
- * in an attempt to reduce the overhead of frequently callng malloc().
+ * Each player's markers are kept in a 64-bit bitboard, so that legal moves
+ * and flipped markers can be found for all squares of a line at once by
+ * shifting and masking; the char board array is only used to draw the board.
+ * The board size is fixed when compiling (-DBOARD_SIZE=n, 8 by default);
+ * boards over 64 squares use 128-bit bitboards.
+ * The best_move() function finds the principal variation (the chain of
+ * best moves) to the depth specified by max_ply.  It is kept in a
+ * triangular table in the search record: row ply holds the chain from
+ * that ply down, and a new best move copies the row below it after
+ * itself, so no memory is allocated during the search.
+ * Positions reached through different move orders are recognized by their
+ * Zobrist hash and looked up in a transposition table, so that a subtree
+ * is not searched twice to the same depth.
+ * Computer moves are found by iterative deepening: best_move() is run to
+ * depth 1, 2, 3... until the skill level is reached or, when a time budget
+ * is given with --movetime, until the budget is spent.
+ * Moves are tried best-first (the stored best move, then by square weight,
+ * killer moves and history counts) so that the alpha-beta cut fires early.
+ * Moves after the first are searched with a null window (principal
+ * variation search), and each iteration starts with a narrow window
+ * around the score of the one before (an aspiration window).
+ * With --probcut, subtrees that a shallow search predicts to fall well
+ * outside the window are not searched (see load_probcut()).
+ * With --threads N, N threads search the same root at once ("Lazy SMP"),
+ * each on its own copy of the board in a search_type record, and share
+ * what they find through the transposition table, without locks.
+ * Once few enough squares are empty (--endgame), the game is instead
+ * solved exactly by solve(), which scores by the final disc differential.
+ * "othello --analyze file" reads positions from a file (or "-" for the
+ * standard input) and prints the search result for each, without prompts;
+ * with --threads N, N workers analyze positions side by side.
+ * With --binary, the positions and results are fixed-size binary records
+ * instead (see record_header_type).
+ * "othello --perft N" counts the positions N moves ahead, to time the move
+ * generator, and "othello --bench" times the search on a fixed suite.
+ * Every search keeps counts of its nodes, cutoffs and table hits, which
+ * --stats writes out as a line of JSON after each computer move.
+ * With --eval, the leaves of the search are scored by tables of pattern
+ * weights (see pattern_score()) instead of by h_func().
+ * With --book, computer moves are taken from an opening book, when it has
+ * the position, instead of being searched.
+ * With --ponder, the computer searches the reply it expects while the
+ * human is thinking.
+ * With --cache, the results of root searches are kept in a file from one
+ * run to the next (see cache_open()).
+ * "othello --server" (or --listen port) stays running and answers search
+ * requests in a line protocol (see serve()).
+ * "othello --selfplay N" plays N games between two engines of the given
+ * depths, several at once with --threads, to measure a change to the search.
  * The board array, the application heap, and the data record for each
  * player could easily be made into C++ objects.
  * The stdio-based I/O lends itself well to portability; this program
@@ -17,344 +65,5467 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
 #include <assert.h>
 #include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <signal.h>
 
 
 /* Constants */
 
+/* The board is BOARD_SIZE squares on a side; build with -DBOARD_SIZE=n
+ * for an even n from 4 to 10.  Every table and loop bound follows from it
+ * at compile time.
+ */
+#ifndef BOARD_SIZE
 #define BOARD_SIZE	8
+#endif
+#if BOARD_SIZE < 4  ||  BOARD_SIZE > 10  ||  BOARD_SIZE % 2 != 0
+#error "BOARD_SIZE must be 4, 6, 8 or 10"
+#endif
 #define NUM_VECTORS	8
-#define MAX_CHANGES	4*(BOARD_SIZE-3)
 #define BOARD_AREA	(BOARD_SIZE*BOARD_SIZE)
-#define MAX_NUM_MOVES	BOARD_AREA-4
+#define MAX_NUM_MOVES	(BOARD_AREA-4)
+#define MAX_PLY		(BOARD_AREA-4)
+
+/* The move lists of every node on a line of search, in the worst case */
+#define MOVE_STACK_SIZE	((MAX_PLY+2)*MAX_NUM_MOVES)
+
+/* INIT_MAX_EFFECT should be less than the sum of the values of
+ * the heuristic function for all board squares.
+ */
+#define INIT_MAX_EFFECT	-9*BOARD_AREA
+
+/* Heuristic function */
+#define idx_weight(x)	((x==0||x==BOARD_SIZE-1)?BOARD_SIZE:1)
+#define h_func(r,c)	(idx_weight(r)*idx_weight(c))
+
+/* Bitboards: square (r,c) is bit r*BOARD_SIZE+c.  Boards of more than
+ * 64 squares need the 128-bit integers of GNU C.
+ */
+
+#if BOARD_AREA > 64  &&  !defined(__SIZEOF_INT128__)
+#error "A bitboard of more than 64 squares needs 128-bit integers"
+#endif
+
+#if BOARD_AREA == 64
+#define FULL_BOARD	(~(bitboard_type)0)
+#else
+#define FULL_BOARD	((((bitboard_type)1) << BOARD_AREA) - 1)
+#endif
+#define FIRST_COL	(FULL_BOARD / ((((bitboard_type)1) << BOARD_SIZE) - 1))
+#define LAST_COL	(FIRST_COL << (BOARD_SIZE - 1))
+#define SQUARE(r,c)	((r)*BOARD_SIZE+(c))
+#define SQUARE_BIT(sq)	(((bitboard_type)1) << (sq))
+
+/* Default transposition table size (--hash); override with -DTT_MEGABYTES=n */
+#ifndef TT_MEGABYTES
+#define TT_MEGABYTES	16
+#endif
+
+/* Default size of a new position cache (--cache-size) */
+#ifndef CACHE_MEGABYTES
+#define CACHE_MEGABYTES	64
+#endif
+
+#define NO_MOVE		0xFF	/* Stored best move of a position with none */
+
+/* Nodes of best_move() and solve() between looks at the clock and the
+ * stop flag; the leaf solvers under solve() do not count toward it
+ */
+#define CLOCK_CHECK_INTERVAL	1024
+
+/* Selective search (--probcut) */
+#define PROBCUT_MAX_PAIRS	64
+#define PROBCUT_T	1.5	/* Default cut threshold, in standard deviations */
+
+/* Half the width of the first window searched around the last
+ * iteration's score; it grows fourfold on each failure
+ */
+#define ASPIRATION_WINDOW	8
+
+/* Empty squares at or below which the game is solved exactly (--endgame) */
+#ifndef ENDGAME_EMPTIES
+#define ENDGAME_EMPTIES	16
+#endif
+#if BOARD_AREA <= 36
+#define ENDGAME_MAX_EMPTIES	(BOARD_AREA-4)	/* Small boards solve from the start */
+#else
+#define ENDGAME_MAX_EMPTIES	30
+#endif
+/* The plies of the longest line searched: the solver's count passes too */
+#if 2*ENDGAME_MAX_EMPTIES > MAX_PLY
+#define MAX_LINE	(2*ENDGAME_MAX_EMPTIES+2)
+#else
+#define MAX_LINE	(MAX_PLY+2)
+#endif
+#define ENDGAME_FASTEST_FIRST	7	/* Above this, order by opponent mobility */
+
+#define BATCH_DEPTH	8	/* Default search depth in batch analysis */
+
+#define BATCH_JOBS	256	/* Positions read ahead of the output, per worker */
+#define BATCH_OUTPUT_SIZE	512
+
+#define BENCH_DEPTH	9	/* Default search depth of --bench */
+#define BENCH_SEED	1992
+#define BENCH_KERNEL_REPS	20000	/* Passes over the suite per kernel */
+
+#define SELFPLAY_DEPTH	6	/* Default search depth of --selfplay */
+#define SELFPLAY_SEED	1992
+#define SELFPLAY_OPENING	6	/* Random moves before the engines take over */
+#define SELFPLAY_TT_MEGABYTES	4	/* Per engine; fixed, for repeatability */
+
+#define MAX_THREADS	64
+#define TT_BUCKET_SLOTS	4	/* Entries looked at per probe: one cache line */
+#define TT_HUGE_PAGE	(2 << 20)
+#define TT_VALID	((uint64_t)1 << 34)	/* Set in every stored entry */
+#define TT_GENERATIONS	0xFFFFFF	/* Mask of the generation stored */
+
+#if defined(__GNUC__)  &&  BOARD_AREA <= 64
+#define bit_count(b)	((unsigned int)__builtin_popcountll(b))
+#define first_bit(b)	((unsigned int)__builtin_ctzll(b))
+#define last_bit(b)	(63 - (unsigned int)__builtin_clzll(b))
+#endif
+
+/* Let the compiler unroll the short loops of the move generator, whose
+ * bounds are all constants
+ */
+#if defined(__GNUC__)  &&  __GNUC__ >= 8
+#define UNROLL		_Pragma( "GCC unroll 16" )
+#else
+#define UNROLL
+#endif
+
+/* Define a boolean type */
+
+#ifndef FALSE
+#ifdef TRUE
+#undef TRUE
+#endif
+typedef enum { FALSE, TRUE } bool;
+#else
+#ifndef TRUE
+#define TRUE 1
+#endif
+typedef char bool;
+#endif
+
+
+/* Other type definitions */
+
+typedef enum {
+	PT_COMP,
+	PT_HUMAN
+} player_type_type;
+
+#if BOARD_AREA > 64
+typedef unsigned __int128 bitboard_type;
+#else
+typedef uint64_t bitboard_type;
+#endif
+
+typedef struct {
+	int drow, dcol;
+	/* One step along the vector, applied to a whole bitboard:
+	 * shift left, shift right, then clear squares that wrapped around
+	 */
+	unsigned int lshift, rshift;
+	bitboard_type mask;
+} vector_type;
+
+typedef struct {
+	unsigned int sq;		/* SQUARE(r,c) of the new marker */
+	bitboard_type flips;		/* The opposing markers it flips */
+} move_type;
+
+typedef enum {
+	TT_EXACT,			/* The score is the value of the position */
+	TT_LOWER,			/* The search failed high; the value is >= score */
+	TT_UPPER			/* The search failed low; the value is <= score */
+} tt_bound_type;
+
+typedef struct {
+	uint64_t key;
+	int16_t score;
+	uint8_t depth;			/* The number of plies searched */
+	uint8_t bound;			/* A tt_bound_type */
+	uint8_t move;			/* The best move's square, or NO_MOVE */
+} tt_entry_type;
+
+/* An entry as stored: the fields packed into data (see tt_store()), and
+ * the key XORed with them.  Threads read and write the table without
+ * locks; an entry that two of them wrote at once fails the check.
+ */
+typedef struct {
+	uint64_t check;			/* key ^ data */
+	uint64_t data;
+} tt_slot_type;
+
+typedef struct {
+	tt_slot_type slot[TT_BUCKET_SLOTS];
+} tt_bucket_type;
+
+typedef struct {
+	volatile tt_bucket_type * table;	/* Aligned to a page */
+	size_t mask;			/* The number of buckets, less 1 */
+	size_t size;			/* In bytes */
+	unsigned int generation;	/* Advanced by every root search */
+	bool isolated;			/* Older generations read as empty */
+	bool huge;			/* Mapped on reserved huge pages */
+} tt_type;
+
+typedef struct player_data_struct {
+	char marker;
+	unsigned int id;		/* 0 or 1; selects its Zobrist keys */
+	bitboard_type discs;		/* The squares holding its markers */
+	unsigned int count;		/* The number of its markers on the board */
+	unsigned int weight;		/* The sum of h_func() over its markers */
+	player_type_type type;
+	struct player_data_struct * opponent;
+} player_data_type;
+
+typedef struct {
+	unsigned int length;
+	uint8_t move[MAX_PLY];		/* Squares, starting with the root's move */
+} pv_type;
+
+typedef struct {
+	int score;			/* The effect, or the final disc differential */
+	bool exact;			/* Solved to the end of the game */
+	unsigned int depth;		/* Of the last completed iteration */
+	bool partial;			/* The move is from the iteration after it */
+	pv_type pv;
+} search_result_type;
+
+/* What a search needs to take back a move: the counts and weights are
+ * restored rather than recomputed from the flips
+ */
+
+typedef struct {
+	bitboard_type flips;
+	uint64_t hash_key;		/* The key before the move */
+	uint16_t weight[2];		/* The mover's and its opponent's, before */
+	uint8_t count[2];
+	uint8_t sq;
+} undo_type;
+
+/* Counters kept by every search; cheap enough to leave on */
+
+typedef struct {
+	unsigned long node_count, cutoff_count, first_move_cutoffs;
+	unsigned long tt_probes, tt_hits, tt_cuts;
+	unsigned long research_count;	/* Root searches redone, window widened */
+	unsigned long probcut_cuts;	/* Subtrees skipped on a shallow search */
+	unsigned long cache_hits;	/* Root results taken from the cache */
+	unsigned long ply_nodes[MAX_LINE];	/* Nodes at each ply of the tree */
+} search_stats_type;
+
+/* The phases of a search that a profiling build (-DPROFILE) times */
+
+typedef enum {
+	PHASE_MOVES,			/* generate_moves() and order_moves() */
+	PHASE_MAKE,			/* make_move() and unmake_move() */
+	PHASE_EVAL,			/* pattern_score() at the leaves */
+	PHASE_TT,			/* tt_probe() and tt_store() */
+	PHASE_PV,			/* Copying chains */
+	PHASE_SOLVE,			/* solve(), the endgame */
+	PHASE_SEARCH,			/* All of a thread's search of a root */
+	NUM_PHASES
+} phase_type;
+
+/* The state of one search thread */
+
+typedef struct {
+	player_data_type players[2];	/* Private copy of the board */
+	unsigned int root_id;		/* The id of the player to move at the root */
+	unsigned int start_depth, max_ply;
+	bool verbose;
+	/* pv[ply] holds pv_length[ply] moves, from ply down */
+	uint8_t pv[MAX_LINE][MAX_PLY];
+	unsigned int pv_length[MAX_LINE];
+	pv_type partial;		/* The iteration's best chain so far */
+	int partial_score;
+	uint64_t hash_key;
+	tt_type * tt;			/* The table it shares with its helpers */
+	unsigned long rand_state;	/* For breaking ties between best moves */
+	double deadline;		/* Seconds on now_seconds()'s clock; 0 = none */
+	volatile bool * stop;		/* Set to make the search finish */
+	volatile bool stop_requested;	/* The flag searches[0] shares */
+	volatile bool * interrupt;	/* If not NULL, set to stop searches[0] */
+	unsigned int clock_countdown;	/* Nodes until the next look at them */
+	bool aborted;
+	search_stats_type stats;
+	unsigned int killer_move[MAX_PLY + 1][2];	/* Squares that caused cutoffs */
+	unsigned long history[2][BOARD_AREA];		/* Cutoff credit per square */
+	/* The nodes of the current line keep their move lists on move_stack,
+	 * and the moves made on it on undo; each node pops what it pushed
+	 */
+	move_type move_stack[MOVE_STACK_SIZE];
+	unsigned int move_sp;
+	undo_type undo[MAX_PLY + 2];
+	unsigned int undo_sp;
+#ifdef PROFILE
+	uint64_t phase_start[NUM_PHASES];	/* See PROFILE_START() */
+	uint64_t phase_cycles[NUM_PHASES];
+	unsigned long phase_calls[NUM_PHASES];
+#endif
+	pthread_t thread;
+} search_type;
+
+
+/* Global variables
+ * Everything a search changes is kept in its search_type record;
+ * these are set up once, or are shared by all search threads.
+ */
+
+bool verbose;
+uint64_t zobrist_key[2][BOARD_AREA], zobrist_side;
+uint64_t zobrist_flip[BOARD_AREA];	/* Both players' keys for a square */
+tt_type shared_tt;		/* The table of the searches main() makes */
+unsigned int endgame_empties = ENDGAME_EMPTIES;
+bitboard_type ray_mask[BOARD_AREA][NUM_VECTORS];	/* Squares beyond sq */
+unsigned int ray_length[BOARD_AREA][NUM_VECTORS];
+unsigned int square_weight[BOARD_AREA];		/* h_func() of each square */
+bitboard_type edge_squares, corner_squares;
+bitboard_type neighbours[BOARD_AREA];	/* The squares next to each square */
+bitboard_type quadrant_mask[4];
+unsigned int quadrant_of[BOARD_AREA];
+
+static const vector_type vector[NUM_VECTORS] = {
+	{ -1, -1, 0, BOARD_SIZE+1, FULL_BOARD & ~LAST_COL },
+	{ -1,  0, 0, BOARD_SIZE,   FULL_BOARD },
+	{ -1,  1, 0, BOARD_SIZE-1, FULL_BOARD & ~FIRST_COL },
+	{  0, -1, 0, 1,            FULL_BOARD & ~LAST_COL },
+	{  0,  1, 1, 0,            FULL_BOARD & ~FIRST_COL },
+	{  1, -1, BOARD_SIZE-1, 0, FULL_BOARD & ~LAST_COL },
+	{  1,  0, BOARD_SIZE,   0, FULL_BOARD },
+	{  1,  1, BOARD_SIZE+1, 0, FULL_BOARD & ~FIRST_COL }
+};
+
+
+#if BOARD_AREA > 64
+/* The bit-twiddling builtins, on the two halves of a 128-bit bitboard */
+
+static unsigned int bit_count( bitboard_type b )
+{
+	return( (unsigned int)( __builtin_popcountll( (uint64_t)b )
+		+ __builtin_popcountll( (uint64_t)(b >> 64) ) ) );
+} /* bit_count() */
+
+
+static unsigned int first_bit( bitboard_type b )
+{
+	return( ( (uint64_t)b != 0 ) ? (unsigned int)__builtin_ctzll( (uint64_t)b )
+		: 64 + (unsigned int)__builtin_ctzll( (uint64_t)(b >> 64) ) );
+} /* first_bit() */
+
+
+static unsigned int last_bit( bitboard_type b )
+{
+	return( ( (uint64_t)(b >> 64) != 0 )
+		? 127 - (unsigned int)__builtin_clzll( (uint64_t)(b >> 64) )
+		: 63 - (unsigned int)__builtin_clzll( (uint64_t)b ) );
+} /* last_bit() */
+#elif !defined(__GNUC__)
+/* Portable versions of the bit-twiddling builtins */
+
+static unsigned int bit_count( bitboard_type b )
+{
+	unsigned int n;
+
+	for( n = 0; b != 0; n++ ) {
+		b &= b - 1;
+	} /* for */
+
+	return( n );
+} /* bit_count() */
+
+
+static unsigned int first_bit( bitboard_type b )
+{
+	unsigned int n;
+
+	for( n = 0; (b & 1) == 0; n++ ) {
+		b >>= 1;
+	} /* for */
+
+	return( n );
+} /* first_bit() */
+
+
+static unsigned int last_bit( bitboard_type b )
+{
+	unsigned int n;
+
+	for( n = 0; (b >>= 1) != 0; n++ ) {
+	} /* for */
+
+	return( n );
+} /* last_bit() */
+#endif
+
+
+/* Move every marker in b one square along vector i */
+
+static bitboard_type shift_bits( bitboard_type b, unsigned int i )
+{
+	return( ((b << vector[i].lshift) >> vector[i].rshift) & vector[i].mask );
+} /* shift_bits() */
+
+
+/* The sum of the square weights over the markers in b */
+
+static unsigned int weight_of( bitboard_type b )
+{
+	return( bit_count( b ) + (BOARD_SIZE - 1) * bit_count( b & edge_squares )
+		+ BOARD_SIZE * (BOARD_SIZE - 1) * bit_count( b & corner_squares ) );
+} /* weight_of() */
+
+
+/* Set up the per-square tables: the ray of squares leading away from each
+ * square along each vector, and the heuristic weight of each square.
+ * The weights take three values, BOARD_SIZE squared in the corners,
+ * BOARD_SIZE along the other edge squares and 1 elsewhere, so the weight
+ * of a whole bitboard takes three bit counts (see weight_of()).
+ */
+
+static void init_board_tables( void )
+{
+	bitboard_type b;
+	unsigned int sq, i;
+
+	edge_squares = corner_squares = 0;
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+		square_weight[sq] = h_func(sq / BOARD_SIZE, sq % BOARD_SIZE);
+
+		if( square_weight[sq] > 1 ) {
+			edge_squares |= SQUARE_BIT(sq);
+		} /* if */
+
+		if( square_weight[sq] == BOARD_SIZE * BOARD_SIZE ) {
+			corner_squares |= SQUARE_BIT(sq);
+		} /* if */
+
+		for( i = 0; i < NUM_VECTORS; i++ ) {
+			ray_mask[sq][i] = 0;
+			ray_length[sq][i] = 0;
+
+			for( b = shift_bits( SQUARE_BIT(sq), i ); b != 0;
+				b = shift_bits( b, i ) ) {
+
+				ray_mask[sq][i] |= b;
+				ray_length[sq][i]++;
+			} /* for */
+		} /* for */
+	} /* for */
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+		assert( weight_of( SQUARE_BIT(sq) ) == square_weight[sq] );
+	} /* for */
+} /* init_board_tables() */
+
+
+/* Find every empty square where the player's marker would flip at least
+ * one opposing marker.  Runs of opposing markers are grown outward from
+ * the player's markers along each vector, for all squares at once.
+ */
+
+static bitboard_type legal_moves_scalar( bitboard_type mine,
+	bitboard_type theirs )
+{
+	bitboard_type moves = 0, run;
+	unsigned int i, k;
+
+	UNROLL
+	for( i = 0; i < NUM_VECTORS; i++ ) {
+		run = shift_bits( mine, i ) & theirs;
+
+		/* A run holds at most BOARD_SIZE-2 opposing markers */
+		UNROLL
+		for( k = 2; k < BOARD_SIZE - 1; k++ ) {
+			run |= shift_bits( run, i ) & theirs;
+		} /* for */
+
+		moves |= shift_bits( run, i );
+	} /* for */
+
+	return( moves & ~(mine | theirs) );
+} /* legal_moves_scalar() */
+
+
+/* Find the opposing markers flipped by placing a marker of mine at sq.
+ * Along each ray, the run of opposing markers ends at the nearest square
+ * that is not theirs; the run is flipped if that square is mine.  Rays
+ * with higher-numbered squares are searched from the low end, and the
+ * others from the high end.
+ */
+
+static bitboard_type compute_flips_scalar( unsigned int sq,
+	bitboard_type mine, bitboard_type theirs )
+{
+	bitboard_type flips = 0, ray, ends, end;
+	unsigned int i;
+
+	UNROLL
+	for( i = 0; i < NUM_VECTORS; i++ ) {
+
+		if( ray_length[sq][i] < 2 ) continue;	/* No room for a run */
+
+		ray = ray_mask[sq][i];
+		ends = ray & ~theirs;
+
+		if( ends == 0 ) continue;
+
+		if( vector[i].lshift > 0 ) {
+			end = ends & (0 - ends);
+			ray &= end - 1;
+		} else {
+			end = SQUARE_BIT( last_bit( ends ) );
+			ray &= ~((end << 1) - 1);
+		} /* if */
+
+		if( (end & mine) != 0 ) {
+			flips |= ray;
+		} /* if */
+	} /* for */
+
+	return( flips );
+} /* compute_flips_scalar() */
+
+
+/* Vector kernels for legal_moves() and compute_flips()
+ * The eight vectors are handled four (AVX2) or two (NEON) at a time: the
+ * ones leading to higher-numbered squares in one register and the others
+ * in another.  The kernel is chosen when the program starts, from what
+ * the processor supports; --kernel overrides the choice.
+ */
+
+typedef enum {
+	KERNEL_SCALAR,
+	KERNEL_AVX2,
+	KERNEL_NEON
+} kernel_type;
+
+static const char * const kernel_name[] = { "scalar", "avx2", "neon" };
+
+kernel_type flip_kernel = KERNEL_SCALAR;
+
+/* The vector kernels work on 64-bit lanes, so only on boards that fit */
+#if BOARD_AREA <= 64
+
+/* Shifts and masks of vectors 4-7 ("up", to higher squares) and 0-3 */
+uint64_t up_shift[4], up_mask[4], down_shift[4], down_mask[4];
+
+#if defined(__GNUC__)  &&  ( defined(__x86_64__)  ||  defined(__i386__) )
+#define HAVE_AVX2_KERNEL
+#include <immintrin.h>
+
+__attribute__(( target( "avx2" ) ))
+static bitboard_type legal_moves_avx2( bitboard_type mine,
+	bitboard_type theirs )
+{
+	__m256i m = _mm256_set1_epi64x( (long long)mine ),
+		t = _mm256_set1_epi64x( (long long)theirs ),
+		us = _mm256_loadu_si256( (const __m256i *)up_shift ),
+		um = _mm256_loadu_si256( (const __m256i *)up_mask ),
+		ds = _mm256_loadu_si256( (const __m256i *)down_shift ),
+		dm = _mm256_loadu_si256( (const __m256i *)down_mask ),
+		up, down, moves;
+	__m128i half;
+	unsigned int k;
+
+	up = _mm256_and_si256( _mm256_and_si256( _mm256_sllv_epi64( m, us ), um ), t );
+	down = _mm256_and_si256( _mm256_and_si256( _mm256_srlv_epi64( m, ds ), dm ), t );
+
+	for( k = 2; k < BOARD_SIZE - 1; k++ ) {
+		up = _mm256_or_si256( up, _mm256_and_si256( _mm256_and_si256(
+			_mm256_sllv_epi64( up, us ), um ), t ) );
+		down = _mm256_or_si256( down, _mm256_and_si256( _mm256_and_si256(
+			_mm256_srlv_epi64( down, ds ), dm ), t ) );
+	} /* for */
+
+	moves = _mm256_or_si256(
+		_mm256_and_si256( _mm256_sllv_epi64( up, us ), um ),
+		_mm256_and_si256( _mm256_srlv_epi64( down, ds ), dm ) );
+	half = _mm_or_si128( _mm256_castsi256_si128( moves ),
+		_mm256_extracti128_si256( moves, 1 ) );
+	return( ( (bitboard_type)_mm_cvtsi128_si64( half )
+		| (bitboard_type)_mm_extract_epi64( half, 1 ) ) & ~(mine | theirs) );
+} /* legal_moves_avx2() */
+
+
+/* The nearest square of each "down" ray that is not theirs is the highest
+ * bit of its ends; smearing the ends downward finds it without a bit scan.
+ */
+
+__attribute__(( target( "avx2" ) ))
+static bitboard_type compute_flips_avx2( unsigned int sq, bitboard_type mine,
+	bitboard_type theirs )
+{
+	__m256i m = _mm256_set1_epi64x( (long long)mine ),
+		t = _mm256_set1_epi64x( (long long)theirs ),
+		zero = _mm256_setzero_si256(), one = _mm256_set1_epi64x( 1 ),
+		ray, ends, end, flips, smear;
+	__m128i half;
+
+	/* Up: the lowest bit of the ends */
+	ray = _mm256_loadu_si256( (const __m256i *)&ray_mask[sq][4] );
+	ends = _mm256_andnot_si256( t, ray );
+	end = _mm256_and_si256( ends, _mm256_sub_epi64( zero, ends ) );
+	flips = _mm256_andnot_si256(
+		_mm256_cmpeq_epi64( _mm256_and_si256( end, m ), zero ),
+		_mm256_and_si256( ray, _mm256_sub_epi64( end, one ) ) );
+
+	/* Down: the highest bit of the ends */
+	ray = _mm256_loadu_si256( (const __m256i *)&ray_mask[sq][0] );
+	ends = _mm256_andnot_si256( t, ray );
+	smear = _mm256_or_si256( ends, _mm256_srli_epi64( ends, 1 ) );
+	smear = _mm256_or_si256( smear, _mm256_srli_epi64( smear, 2 ) );
+	smear = _mm256_or_si256( smear, _mm256_srli_epi64( smear, 4 ) );
+	smear = _mm256_or_si256( smear, _mm256_srli_epi64( smear, 8 ) );
+	smear = _mm256_or_si256( smear, _mm256_srli_epi64( smear, 16 ) );
+	smear = _mm256_or_si256( smear, _mm256_srli_epi64( smear, 32 ) );
+	end = _mm256_andnot_si256( _mm256_srli_epi64( smear, 1 ), smear );
+	flips = _mm256_or_si256( flips, _mm256_andnot_si256(
+		_mm256_cmpeq_epi64( _mm256_and_si256( end, m ), zero ),
+		_mm256_andnot_si256( smear, ray ) ) );
+
+	half = _mm_or_si128( _mm256_castsi256_si128( flips ),
+		_mm256_extracti128_si256( flips, 1 ) );
+	return( (bitboard_type)_mm_cvtsi128_si64( half )
+		| (bitboard_type)_mm_extract_epi64( half, 1 ) );
+} /* compute_flips_avx2() */
+#endif
+
+
+#if defined(__ARM_NEON)  &&  defined(__aarch64__)
+#define HAVE_NEON_KERNEL
+#include <arm_neon.h>
+
+static bitboard_type legal_moves_neon( bitboard_type mine,
+	bitboard_type theirs )
+{
+	uint64x2_t m = vdupq_n_u64( mine ), t = vdupq_n_u64( theirs ),
+		um0 = vld1q_u64( &up_mask[0] ), um1 = vld1q_u64( &up_mask[2] ),
+		dm0 = vld1q_u64( &down_mask[0] ), dm1 = vld1q_u64( &down_mask[2] ),
+		up0, up1, down0, down1, moves;
+	int64x2_t us0 = vreinterpretq_s64_u64( vld1q_u64( &up_shift[0] ) ),
+		us1 = vreinterpretq_s64_u64( vld1q_u64( &up_shift[2] ) ),
+		ds0 = vnegq_s64( vreinterpretq_s64_u64( vld1q_u64( &down_shift[0] ) ) ),
+		ds1 = vnegq_s64( vreinterpretq_s64_u64( vld1q_u64( &down_shift[2] ) ) );
+	unsigned int k;
+
+	/* vshlq_u64() shifts right by a negative count */
+	up0 = vandq_u64( vandq_u64( vshlq_u64( m, us0 ), um0 ), t );
+	up1 = vandq_u64( vandq_u64( vshlq_u64( m, us1 ), um1 ), t );
+	down0 = vandq_u64( vandq_u64( vshlq_u64( m, ds0 ), dm0 ), t );
+	down1 = vandq_u64( vandq_u64( vshlq_u64( m, ds1 ), dm1 ), t );
+
+	for( k = 2; k < BOARD_SIZE - 1; k++ ) {
+		up0 = vorrq_u64( up0, vandq_u64( vandq_u64( vshlq_u64( up0, us0 ),
+			um0 ), t ) );
+		up1 = vorrq_u64( up1, vandq_u64( vandq_u64( vshlq_u64( up1, us1 ),
+			um1 ), t ) );
+		down0 = vorrq_u64( down0, vandq_u64( vandq_u64( vshlq_u64( down0,
+			ds0 ), dm0 ), t ) );
+		down1 = vorrq_u64( down1, vandq_u64( vandq_u64( vshlq_u64( down1,
+			ds1 ), dm1 ), t ) );
+	} /* for */
+
+	moves = vorrq_u64(
+		vorrq_u64( vandq_u64( vshlq_u64( up0, us0 ), um0 ),
+			vandq_u64( vshlq_u64( up1, us1 ), um1 ) ),
+		vorrq_u64( vandq_u64( vshlq_u64( down0, ds0 ), dm0 ),
+			vandq_u64( vshlq_u64( down1, ds1 ), dm1 ) ) );
+	return( ( vgetq_lane_u64( moves, 0 ) | vgetq_lane_u64( moves, 1 ) )
+		& ~(mine | theirs) );
+} /* legal_moves_neon() */
+
+
+static bitboard_type compute_flips_neon( unsigned int sq, bitboard_type mine,
+	bitboard_type theirs )
+{
+	uint64x2_t m = vdupq_n_u64( mine ), t = vdupq_n_u64( theirs ),
+		zero = vdupq_n_u64( 0 ), one = vdupq_n_u64( 1 ),
+		ray, ends, end, smear, flips = vdupq_n_u64( 0 );
+	unsigned int i;
+
+	for( i = 4; i < NUM_VECTORS; i += 2 ) {	/* Up: the lowest end */
+		ray = vld1q_u64( &ray_mask[sq][i] );
+		ends = vbicq_u64( ray, t );
+		end = vandq_u64( ends, vsubq_u64( zero, ends ) );
+		flips = vorrq_u64( flips, vandq_u64( vtstq_u64( end, m ),
+			vandq_u64( ray, vsubq_u64( end, one ) ) ) );
+	} /* for */
+
+	for( i = 0; i < 4; i += 2 ) {	/* Down: the highest end */
+		ray = vld1q_u64( &ray_mask[sq][i] );
+		ends = vbicq_u64( ray, t );
+		smear = vorrq_u64( ends, vshrq_n_u64( ends, 1 ) );
+		smear = vorrq_u64( smear, vshrq_n_u64( smear, 2 ) );
+		smear = vorrq_u64( smear, vshrq_n_u64( smear, 4 ) );
+		smear = vorrq_u64( smear, vshrq_n_u64( smear, 8 ) );
+		smear = vorrq_u64( smear, vshrq_n_u64( smear, 16 ) );
+		smear = vorrq_u64( smear, vshrq_n_u64( smear, 32 ) );
+		end = vbicq_u64( smear, vshrq_n_u64( smear, 1 ) );
+		flips = vorrq_u64( flips, vandq_u64( vtstq_u64( end, m ),
+			vbicq_u64( ray, smear ) ) );
+	} /* for */
+
+	return( vgetq_lane_u64( flips, 0 ) | vgetq_lane_u64( flips, 1 ) );
+} /* compute_flips_neon() */
+#endif
+#endif /* BOARD_AREA <= 64 */
+
+
+/* Set up the kernels' shift tables, and choose the best kernel the
+ * processor has
+ */
+
+static void init_kernels( void )
+{
+#if BOARD_AREA <= 64
+	unsigned int k;
+
+	for( k = 0; k < 4; k++ ) {
+		up_shift[k] = vector[k + 4].lshift;
+		up_mask[k] = vector[k + 4].mask;
+		down_shift[k] = vector[k].rshift;
+		down_mask[k] = vector[k].mask;
+	} /* for */
+#endif
+
+#ifdef HAVE_NEON_KERNEL
+	flip_kernel = KERNEL_NEON;	/* Always present on AArch64 */
+#endif
+#ifdef HAVE_AVX2_KERNEL
+	__builtin_cpu_init();
+
+	if( __builtin_cpu_supports( "avx2" ) ) {
+		flip_kernel = KERNEL_AVX2;
+	} /* if */
+#endif
+} /* init_kernels() */
+
+
+/* Make kernel the one in use, if this processor can run it */
+
+static bool select_kernel( kernel_type kernel )
+{
+	switch( kernel ) {
+	case KERNEL_SCALAR:
+		break;
+#ifdef HAVE_AVX2_KERNEL
+	case KERNEL_AVX2:
+		if( !__builtin_cpu_supports( "avx2" ) ) return( FALSE );
+		break;
+#endif
+#ifdef HAVE_NEON_KERNEL
+	case KERNEL_NEON:
+		break;
+#endif
+	default:
+		return( FALSE );
+	} /* switch */
+
+	flip_kernel = kernel;
+	return( TRUE );
+} /* select_kernel() */
+
+
+static bitboard_type legal_moves( bitboard_type mine, bitboard_type theirs )
+{
+#ifdef HAVE_AVX2_KERNEL
+	if( flip_kernel == KERNEL_AVX2 ) return( legal_moves_avx2( mine, theirs ) );
+#endif
+#ifdef HAVE_NEON_KERNEL
+	if( flip_kernel == KERNEL_NEON ) return( legal_moves_neon( mine, theirs ) );
+#endif
+	return( legal_moves_scalar( mine, theirs ) );
+} /* legal_moves() */
+
+
+static bitboard_type compute_flips( unsigned int sq, bitboard_type mine,
+	bitboard_type theirs )
+{
+#ifdef HAVE_AVX2_KERNEL
+	if( flip_kernel == KERNEL_AVX2 ) {
+		return( compute_flips_avx2( sq, mine, theirs ) );
+	} /* if */
+#endif
+#ifdef HAVE_NEON_KERNEL
+	if( flip_kernel == KERNEL_NEON ) {
+		return( compute_flips_neon( sq, mine, theirs ) );
+	} /* if */
+#endif
+	return( compute_flips_scalar( sq, mine, theirs ) );
+} /* compute_flips() */
+
+
+/* List the player's legal moves, without touching the board.
+ * Returns the number of moves placed in move_list.
+ */
+
+static unsigned int generate_moves( const player_data_type * player,
+	move_type move_list[MAX_NUM_MOVES] )
+{
+	bitboard_type moves;
+	unsigned int num_moves = 0;
+
+	for( moves = legal_moves( player->discs, player->opponent->discs );
+		moves != 0; moves &= moves - 1 ) {
+
+		move_list[num_moves].sq = first_bit( moves );
+		move_list[num_moves].flips = compute_flips( move_list[num_moves].sq,
+			player->discs, player->opponent->discs );
+		num_moves++;
+	} /* for */
+
+	return( num_moves );
+} /* generate_moves() */
+
+
+/* Pattern evaluation ("--eval patterns" or "--eval file")
+ * Instead of summing h_func() over the markers each move places and flips,
+ * the positions at the leaves of the search are scored as a whole, from
+ * the side of the player who has just moved:  each edge, each corner's
+ * 3x3 block and each long diagonal is read as a base-3 number (0 for an
+ * empty square, 1 for the player's marker, 2 for the opponent's) that
+ * indexes a table of weights, and the mobility of both sides is looked up
+ * in a table of its own.  The corner orientations share one table, as do
+ * the edges and the diagonals, each read outward from a corner.
+ * The weights are built in, or read from a file written by --save-eval:
+ * an eval_file_header_type, then the edge, corner, diagonal and mobility
+ * tables as int16_t in the machine's byte order.  The file is mapped into
+ * memory rather than read, so that several processes share one copy.
+ */
+
+#define EVAL_MAGIC	"OTHW"
+#define EVAL_LIMIT	(8*BOARD_AREA)	/* Keeps scores above INIT_MAX_EFFECT */
+
+#define NUM_EDGES	4
+#define NUM_CORNERS	4
+#define NUM_DIAGONALS	2
+#define CORNER_SIZE	3		/* The corner block is CORNER_SIZE square */
+#define CORNER_LENGTH	(CORNER_SIZE*CORNER_SIZE)
+
+typedef struct {
+	char magic[4];			/* EVAL_MAGIC */
+	uint32_t board_size;		/* BOARD_SIZE */
+	uint32_t num_weights;		/* The int16_t weights that follow */
+} eval_file_header_type;
+
+bool pattern_eval = FALSE;	/* Set to score leaves with the patterns */
+unsigned int edge_codes, corner_codes;	/* Table sizes, powers of 3 */
+unsigned int edge_sq[NUM_EDGES][BOARD_SIZE];
+unsigned int corner_sq[NUM_CORNERS][CORNER_LENGTH];
+unsigned int diagonal_sq[NUM_DIAGONALS][BOARD_SIZE];
+const int16_t * edge_weights, * corner_weights, * diagonal_weights,
+	* mobility_weights;		/* BOARD_AREA + 1 of these */
+
+
+/* The base-3 code of the given squares, from mine's point of view */
+
+static unsigned int pattern_code( const unsigned int * sq, unsigned int n,
+	bitboard_type mine, bitboard_type theirs )
+{
+	unsigned int code = 0;
+
+	while( n-- > 0 ) {
+		code = 3 * code + ( ( mine & SQUARE_BIT( sq[n] ) ) ? 1
+			: ( theirs & SQUARE_BIT( sq[n] ) ) ? 2 : 0 );
+	} /* while */
+
+	return( code );
+} /* pattern_code() */
+
+
+/* Score the position for player, who has just moved */
+
+static int pattern_score( const player_data_type * player )
+{
+	bitboard_type mine = player->discs, theirs = player->opponent->discs;
+	unsigned int i;
+	int score;
+
+	score = mobility_weights[bit_count( legal_moves( mine, theirs ) )]
+		- mobility_weights[bit_count( legal_moves( theirs, mine ) )];
+
+	for( i = 0; i < NUM_EDGES; i++ ) {
+		score += edge_weights[pattern_code( edge_sq[i], BOARD_SIZE,
+			mine, theirs )];
+	} /* for */
+
+	for( i = 0; i < NUM_CORNERS; i++ ) {
+		score += corner_weights[pattern_code( corner_sq[i], CORNER_LENGTH,
+			mine, theirs )];
+	} /* for */
+
+	for( i = 0; i < NUM_DIAGONALS; i++ ) {
+		score += diagonal_weights[pattern_code( diagonal_sq[i], BOARD_SIZE,
+			mine, theirs )];
+	} /* for */
+
+	return( ( score > EVAL_LIMIT ) ? EVAL_LIMIT
+		: ( score < -EVAL_LIMIT ) ? -EVAL_LIMIT : score );
+} /* pattern_score() */
+
+
+/* The built-in weight of one square of a pattern, given its digit
+ * (1 mine, 2 theirs) and the digit of the corner it belongs to
+ */
+
+static int default_weight( int value, unsigned int digit )
+{
+	return( ( digit == 1 ) ? value : ( digit == 2 ) ? -value : 0 );
+} /* default_weight() */
+
+
+/* Fill the tables with the built-in weights:  corners are worth most, the
+ * squares next to an empty corner are a liability, and mobility counts.
+ * Every table is antisymmetric, so that a position scores the same for
+ * one side as it does against the other.
+ */
+
+static void default_eval( int16_t * edge, int16_t * corner, int16_t * diagonal,
+	int16_t * mobility )
+{
+	unsigned int code, c, i, digit[CORNER_LENGTH > BOARD_SIZE
+		? CORNER_LENGTH : BOARD_SIZE];
+	int score;
+
+	for( code = 0; code < edge_codes; code++ ) {
+
+		for( c = code, i = 0; i < BOARD_SIZE; i++, c /= 3 ) {
+			digit[i] = c % 3;
+		} /* for */
+
+		/* Edges:  corners, then the C-squares next to them */
+		score = default_weight( 20, digit[0] )
+			+ default_weight( 20, digit[BOARD_SIZE - 1] );
+		score += default_weight( digit[0] ? 2 : -3, digit[1] )
+			+ default_weight( digit[BOARD_SIZE - 1] ? 2 : -3,
+				digit[BOARD_SIZE - 2] );
+
+		for( i = 2; i + 2 < BOARD_SIZE; i++ ) {
+			score += default_weight( 2, digit[i] );
+		} /* for */
+
+		edge[code] = (int16_t)score;
+
+		/* Diagonals:  the middle squares; the ends belong to the corners */
+		for( score = 0, i = 2; i + 2 < BOARD_SIZE; i++ ) {
+			score += default_weight( 1, digit[i] );
+		} /* for */
+
+		diagonal[code] = (int16_t)score;
+	} /* for */
+
+	for( code = 0; code < corner_codes; code++ ) {
+
+		for( c = code, i = 0; i < CORNER_LENGTH; i++, c /= 3 ) {
+			digit[i] = c % 3;
+		} /* for */
+
+		/* The X-square, diagonally next to the corner */
+		corner[code] = (int16_t)default_weight( digit[0] ? 2 : -10,
+			digit[CORNER_SIZE + 1] );
+	} /* for */
+
+	for( i = 0; i <= BOARD_AREA; i++ ) {
+		mobility[i] = (int16_t)( 4 * i );
+	} /* for */
+} /* default_eval() */
+
+
+/* Set up the pattern squares, and the built-in weights or those mapped
+ * from file_name.  Returns FALSE if the file cannot be used.
+ */
+
+static bool init_eval( const char * file_name )
+{
+	static int16_t * weights = NULL;
+	const eval_file_header_type * header;
+	unsigned int i, j, k, num_weights;
+	struct stat st;
+	void * map;
+	int fd;
+
+	for( edge_codes = 1, i = 0; i < BOARD_SIZE; i++ ) {
+		edge_codes *= 3;
+	} /* for */
+
+	for( corner_codes = 1, i = 0; i < CORNER_LENGTH; i++ ) {
+		corner_codes *= 3;
+	} /* for */
+
+	/* Each pattern is read outward from a corner */
+	for( i = 0; i < BOARD_SIZE; i++ ) {
+		edge_sq[0][i] = SQUARE(0, i);
+		edge_sq[1][i] = SQUARE(i, BOARD_SIZE - 1);
+		edge_sq[2][i] = SQUARE(BOARD_SIZE - 1, BOARD_SIZE - 1 - i);
+		edge_sq[3][i] = SQUARE(BOARD_SIZE - 1 - i, 0);
+		diagonal_sq[0][i] = SQUARE(i, i);
+		diagonal_sq[1][i] = SQUARE(i, BOARD_SIZE - 1 - i);
+	} /* for */
+
+	for( k = 0; k < NUM_CORNERS; k++ ) {
+
+		for( i = 0; i < CORNER_SIZE; i++ ) {
+
+			for( j = 0; j < CORNER_SIZE; j++ ) {
+				corner_sq[k][i * CORNER_SIZE + j] = SQUARE(
+					( k & 2 ) ? BOARD_SIZE - 1 - i : i,
+					( k & 1 ) ? BOARD_SIZE - 1 - j : j );
+			} /* for */
+		} /* for */
+	} /* for */
+
+	num_weights = 2 * edge_codes + corner_codes + BOARD_AREA + 1;
+
+	if( file_name == NULL ) {
+
+		if( weights == NULL ) {
+			weights = (int16_t *)malloc( num_weights * sizeof( int16_t ) );
+
+			if( weights == NULL ) return( FALSE );
+
+			default_eval( weights, weights + edge_codes,
+				weights + edge_codes + corner_codes,
+				weights + 2 * edge_codes + corner_codes );
+		} /* if */
+
+		header = NULL;
+		edge_weights = weights;
+	} else {
+		fd = open( file_name, O_RDONLY );
+
+		if( fd < 0 ) return( FALSE );
+
+		if( fstat( fd, &st ) != 0  ||  (size_t)st.st_size
+			!= sizeof( *header ) + num_weights * sizeof( int16_t ) ) {
+
+			close( fd );
+			return( FALSE );
+		} /* if */
+
+		map = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+		close( fd );
+
+		if( map == MAP_FAILED ) return( FALSE );
+
+		header = (const eval_file_header_type *)map;
+
+		if( memcmp( header->magic, EVAL_MAGIC, 4 ) != 0
+			||  header->board_size != BOARD_SIZE
+			||  header->num_weights != num_weights ) {
+
+			munmap( map, st.st_size );
+			return( FALSE );
+		} /* if */
+
+		/* Left mapped until the program exits */
+		edge_weights = (const int16_t *)( header + 1 );
+	} /* if */
+
+	corner_weights = edge_weights + edge_codes;
+	diagonal_weights = corner_weights + corner_codes;
+	mobility_weights = diagonal_weights + edge_codes;
+	pattern_eval = TRUE;
+	return( TRUE );
+} /* init_eval() */
+
+
+/* Write the weights in use in the form init_eval() maps */
+
+static bool save_eval( const char * file_name )
+{
+	eval_file_header_type header;
+	FILE * out = fopen( file_name, "wb" );
+	bool ok;
+
+	if( out == NULL ) return( FALSE );
+
+	memcpy( header.magic, EVAL_MAGIC, 4 );
+	header.board_size = BOARD_SIZE;
+	header.num_weights = 2 * edge_codes + corner_codes + BOARD_AREA + 1;
+	ok = fwrite( &header, sizeof( header ), 1, out ) == 1
+		&&  fwrite( edge_weights, sizeof( int16_t ), header.num_weights, out )
+			== header.num_weights;
+	return( fclose( out ) == 0  &&  ok );
+} /* save_eval() */
+
+
+/* Wall-clock time in seconds, for the move-time budget */
+
+static double now_seconds( void )
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( ts.tv_sec + ts.tv_nsec * 1e-9 );
+#else
+	return( (double)time( NULL ) );
+#endif
+} /* now_seconds() */
+
+
+/* Fill the Zobrist key tables from a fixed pseudo-random sequence
+ * (splitmix64), so that they do not depend on the seed given to rand()
+ */
+
+static void init_zobrist( void )
+{
+	uint64_t seed = 0x9E3779B97F4A7C15ULL, z;
+	unsigned int i, sq;
+
+	for( i = 0; i <= 2 * BOARD_AREA; i++ ) {
+		seed += 0x9E3779B97F4A7C15ULL;
+		z = seed;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+
+		if( i == 2 * BOARD_AREA ) {
+			zobrist_side = z;
+		} else {
+			sq = i % BOARD_AREA;
+			zobrist_key[i / BOARD_AREA][sq] = z;
+		} /* if */
+	} /* for */
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+		zobrist_flip[sq] = zobrist_key[0][sq] ^ zobrist_key[1][sq];
+	} /* for */
+} /* init_zobrist() */
+
+
+/* Compute the hash of the board with the given player to move */
+
+static uint64_t hash_position( const player_data_type * player )
+{
+	bitboard_type b;
+	uint64_t key = ( player->id != 0 ) ? zobrist_side : 0;
+
+	for( b = player->discs; b != 0; b &= b - 1 ) {
+		key ^= zobrist_key[player->id][first_bit( b )];
+	} /* for */
+
+	for( b = player->opponent->discs; b != 0; b &= b - 1 ) {
+		key ^= zobrist_key[player->opponent->id][first_bit( b )];
+	} /* for */
+
+	return( key );
+} /* hash_position() */
+
+
+/* Allocate the transposition table: the largest power of two buckets
+ * that fits in the given number of bytes.  It is mapped on reserved huge
+ * pages when the system has enough of them, and otherwise the kernel is
+ * asked to back it with transparent huge pages, so that probes into a
+ * large table do not also miss in the TLB.
+ */
+
+static void tt_init( tt_type * tt, size_t bytes )
+{
+	void * map = MAP_FAILED;
+	size_t num_buckets = 1;
+
+	while( 2 * num_buckets * sizeof( tt_bucket_type ) <= bytes ) {
+		num_buckets *= 2;
+	} /* while */
+
+	tt->size = num_buckets * sizeof( tt_bucket_type );
+	tt->huge = FALSE;
+
+#ifdef MAP_HUGETLB
+	if( tt->size % TT_HUGE_PAGE == 0 ) {
+		map = mmap( NULL, tt->size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+		tt->huge = ( map != MAP_FAILED ) ? TRUE : FALSE;
+	} /* if */
+#endif
+
+	if( map == MAP_FAILED ) {
+		map = mmap( NULL, tt->size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+		if( map == MAP_FAILED ) {
+			fprintf( stderr, "Cannot allocate the transposition table\n" );
+			exit( 1 );
+		} /* if */
+
+#ifdef MADV_HUGEPAGE
+		madvise( map, tt->size, MADV_HUGEPAGE );
+#endif
+	} /* if */
+
+	/* Anonymous pages come zeroed: every entry is empty */
+	tt->table = (volatile tt_bucket_type *)map;
+	tt->mask = num_buckets - 1;
+	tt->generation = 0;
+	tt->isolated = FALSE;
+} /* tt_init() */
+
+
+static void tt_free( tt_type * tt )
+{
+	munmap( (void *)tt->table, tt->size );
+} /* tt_free() */
+
+
+/* Forget every entry */
+
+static void tt_clear( tt_type * tt )
+{
+	memset( (void *)tt->table, 0, tt->size );
+	tt->generation = 0;
+} /* tt_clear() */
+
+
+/* Whether an entry as stored is empty: never written, or in an isolated
+ * table, left by an earlier search
+ */
+
+#define tt_empty(tt,data)	(((data) & TT_VALID) == 0  ||  ((tt)->isolated \
+	&&  ((data) >> 40 & TT_GENERATIONS) != ((tt)->generation & TT_GENERATIONS)))
+
+
+/* Copy out the entry for a position; return FALSE if there is none.
+ * All the entries a position may be in share one cache line.
+ */
+
+static bool tt_probe( tt_type * tt, uint64_t key, tt_entry_type * entry )
+{
+	volatile tt_slot_type * slot = tt->table[key & tt->mask].slot;
+	uint64_t data;
+	unsigned int i;
+
+	for( i = 0; i < TT_BUCKET_SLOTS; i++ ) {
+		data = slot[i].data;
+
+		if( !tt_empty( tt, data )  &&  ( slot[i].check ^ data ) == key ) {
+			entry->key = key;
+			entry->score = (int16_t)( data & 0xFFFF );
+			entry->depth = (uint8_t)( data >> 16 );
+			entry->move = (uint8_t)( data >> 24 );
+			entry->bound = (uint8_t)( data >> 32 & 3 );
+			return( TRUE );
+		} /* if */
+	} /* for */
+
+	return( FALSE );
+} /* tt_probe() */
+
+
+/* Record a search result.  A deeper result for the same position, from
+ * the current search, is kept.  A new position takes the entry of its
+ * bucket worth least: an empty one, or else one left by an earlier search,
+ * or else the one searched to the least depth.
+ */
+
+static void tt_store( tt_type * tt, uint64_t key, unsigned int depth,
+	tt_bound_type bound, int score, unsigned int move )
+{
+	volatile tt_slot_type * slot = tt->table[key & tt->mask].slot,
+		* victim = NULL;
+	uint64_t data, old;
+	unsigned int i, generation = tt->generation & TT_GENERATIONS;
+	int worth, victim_worth = 0;
+
+	data = (uint64_t)(uint16_t)score | (uint64_t)( depth & 0xFF ) << 16
+		| (uint64_t)( move & 0xFF ) << 24 | (uint64_t)bound << 32
+		| TT_VALID | (uint64_t)generation << 40;
+
+	for( i = 0; i < TT_BUCKET_SLOTS; i++ ) {
+		old = slot[i].data;
+
+		if( tt_empty( tt, old ) ) {
+			worth = -1;
+		} else {
+			worth = (int)( old >> 16 & 0xFF )
+				+ ( ( ( old >> 40 & TT_GENERATIONS ) == generation ) ? 256 : 0 );
+
+			if( ( slot[i].check ^ old ) == key ) {
+
+				if( worth > (int)depth + 256 ) return;
+
+				victim = &slot[i];
+				break;
+			} /* if */
+		} /* if */
+
+		if( victim == NULL  ||  worth < victim_worth ) {
+			victim = &slot[i];
+			victim_worth = worth;
+		} /* if */
+	} /* for */
+
+	victim->data = data;
+	victim->check = key ^ data;
+} /* tt_store() */
+
+
+/* A rand() of the search's own, since the threads cannot share one */
+
+static unsigned int search_rand( search_type * search )
+{
+	search->rand_state = search->rand_state * 1103515245UL + 12345;
+	return( (unsigned int)( search->rand_state >> 16 ) & 0x7FFF );
+} /* search_rand() */
+
+
+/* Initialize a player's record.
+ * This would make a wonderful constructor in C++
+ */
+
+static void set_player_data( player_data_type * player )
+{
+	char str[10];
+
+	/* Marker must already be set */
+
+	do {
+		printf( "%c: (h)uman or (c)omputer: ", player->marker );
+		scanf( "%s", str );
+	} while( str[0] != 'h'  &&  str[0] != 'c' );
+
+	player->type = ( str[0] == 'h' ) ? PT_HUMAN : PT_COMP;
+} /* set_player_data() */
+
+
+/* Crude but highly portable output */
+
+static void draw_board( const player_data_type * player )
+{
+	char board[BOARD_SIZE][BOARD_SIZE + 1];
+	bitboard_type bit;
+	unsigned int row, col;
+
+	for( row = 0; row < BOARD_SIZE; row++ ) {
+
+		for( col = 0; col < BOARD_SIZE; col++ ) {
+			bit = SQUARE_BIT( SQUARE(row,col) );
+			board[row][col] = ( player->discs & bit ) ? player->marker
+				: ( player->opponent->discs & bit ) ? player->opponent->marker
+				: ' ';
+		} /* for */
+
+		board[row][BOARD_SIZE] = '\0';
+	} /* for */
+
+	printf( "\n       " );
+
+	for( col = 0; col < BOARD_SIZE; col++ ) {
+		printf( "%1d", col );
+	} /* for */
+
+	printf( "\n      +%.*s+\n", BOARD_SIZE, "----------" );
+
+	for( row = 0; row < BOARD_SIZE; row++ ) {
+		printf( "    %1d |%s|\n", row, board[row] );
+	} /* for */
+
+	printf( "      +%.*s+\n\n\n", BOARD_SIZE, "----------" );
+} /* draw_board() */
+
+
+/* Place the player's marker and flip the opposing markers, updating
+ * the position's hash key and the players' weights; return the heuristic
+ * gain, the rise in the player's weight.
+ */
+
+static unsigned int apply_move( player_data_type * player,
+	const move_type * move, uint64_t * keyP )
+{
+	uint64_t key = *keyP;
+	bitboard_type b;
+	unsigned int num_changed = bit_count( move->flips ),
+		gain = square_weight[move->sq] + weight_of( move->flips );
+
+	key ^= zobrist_side ^ zobrist_key[player->id][move->sq];
+
+	for( b = move->flips; b != 0; b &= b - 1 ) {
+		key ^= zobrist_flip[first_bit( b )];
+	} /* for */
+
+	player->discs |= move->flips | SQUARE_BIT( move->sq );
+	player->opponent->discs &= ~move->flips;
+	player->count += num_changed + 1;
+	player->opponent->count -= num_changed;
+	player->weight += gain;
+	player->opponent->weight -= gain - square_weight[move->sq];
+	*keyP = key;
+	return( gain );
+} /* apply_move() */
+
+
+/* Remove the player's marker and restore the flipped ones */
+
+static void undo_move( player_data_type * player, const move_type * move )
+{
+	unsigned int num_changed = bit_count( move->flips ),
+		flip_weight = weight_of( move->flips );
+
+	player->discs ^= move->flips | SQUARE_BIT( move->sq );
+	player->opponent->discs |= move->flips;
+	player->count -= num_changed + 1;
+	player->opponent->count += num_changed;
+	player->weight -= square_weight[move->sq] + flip_weight;
+	player->opponent->weight += flip_weight;
+} /* undo_move() */
+
+
+/* Make a move in a search, updating its hash key, and push what
+ * unmake_move() needs to take it back
+ */
+
+static unsigned int make_move( search_type * search, player_data_type * player,
+	const move_type * move )
+{
+	undo_type * u = &search->undo[search->undo_sp++];
+
+	u->flips = move->flips;
+	u->hash_key = search->hash_key;
+	u->weight[0] = (uint16_t)player->weight;
+	u->weight[1] = (uint16_t)player->opponent->weight;
+	u->count[0] = (uint8_t)player->count;
+	u->count[1] = (uint8_t)player->opponent->count;
+	u->sq = (uint8_t)move->sq;
+	return( apply_move( player, move, &search->hash_key ) );
+} /* make_move() */
+
+
+/* Take back the last move the search made, which player made */
+
+static void unmake_move( search_type * search, player_data_type * player )
+{
+	const undo_type * u = &search->undo[--search->undo_sp];
+
+	player->discs ^= u->flips | SQUARE_BIT( u->sq );
+	player->opponent->discs |= u->flips;
+	player->weight = u->weight[0];
+	player->opponent->weight = u->weight[1];
+	player->count = u->count[0];
+	player->opponent->count = u->count[1];
+	search->hash_key = u->hash_key;
+} /* unmake_move() */
+
+
+/* Using a heuristic, compute the gain resulting from a player's move.
+ * The move is made if it flips anything.
+ */
+
+static unsigned int compute_effect( unsigned int row, unsigned int col,
+	player_data_type * player )
+{
+	move_type move;
+	unsigned int heur_total = 0;
+	uint64_t key = 0;	/* Searches hash their root positions afresh */
+
+	move.sq = SQUARE(row,col);
+	move.flips = compute_flips( move.sq, player->discs,
+		player->opponent->discs );
+
+	if( move.flips != 0 ) {
+		heur_total = apply_move( player, &move, &key );
+	} /* if */
+
+	return( heur_total );
+} /* compute_effect() */
+
+
+/* Tracing is compiled in only with -DTRACE, and then shown when the
+ * "verbose" question is answered with y; otherwise TRACE_PRINT() leaves
+ * nothing behind in the search.  TRACE_PRINT( search, ( format, ... ) )
+ * prints when that search is verbose.
+ */
+
+#ifdef TRACE
+#define TRACE_PRINT(search,args) \
+	do { if( (search)->verbose ) printf args; } while( 0 )
+
+/* Report a finished node of best_move(): its best move and effect, the
+ * time spent below it, and the chain from this ply down
+ */
+
+static void trace_node( const search_type * search,
+	const player_data_type * player, unsigned int ply,
+	unsigned int num_best_moves, int max_effect, double elapsed )
+{
+	unsigned int i;
+
+	printf( "Chose one of %d moves\n", num_best_moves );
+	printf( "Ply %d: %c @ (%d,%d) => %d in %.1f microseconds; chain:", ply,
+		player->marker, search->pv[ply][0] / BOARD_SIZE,
+		search->pv[ply][0] % BOARD_SIZE, max_effect, elapsed * 1.0e6 );
+
+	for( i = 0; i < search->pv_length[ply]; i++ ) {
+		printf( " (%d,%d)", search->pv[ply][i] / BOARD_SIZE,
+			search->pv[ply][i] % BOARD_SIZE );
+	} /* for */
+
+	printf( "\n" );
+} /* trace_node() */
+#else
+#define TRACE_PRINT(search,args)	((void)0)
+#endif
+
+
+/* Profiling is compiled in only with -DPROFILE ("make profile").
+ * PROFILE_START( search, phase ) and PROFILE_STOP( search, phase )
+ * bracket a phase of the search, and add the cycles spent in it to the
+ * search record; search_root() adds those of all its threads to
+ * profile_total, which is printed at exit by profile_report().  The cycle
+ * counter is the time stamp counter on x86, the virtual counter on ARM,
+ * and nanoseconds elsewhere.  Otherwise the macros leave nothing behind.
+ */
+
+#ifdef PROFILE
+#if defined(__GNUC__)  &&  ( defined(__x86_64__)  ||  defined(__i386__) )
+#define read_cycles()	((uint64_t)__builtin_ia32_rdtsc())
+#elif defined(__GNUC__)  &&  defined(__aarch64__)
+static uint64_t read_cycles( void )
+{
+	uint64_t t;
+
+	__asm__ __volatile__( "mrs %0, cntvct_el0" : "=r" (t) );
+	return( t );
+} /* read_cycles() */
+#else
+static uint64_t read_cycles( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec );
+} /* read_cycles() */
+#endif
+
+#define PROFILE_START(search,phase) \
+	((search)->phase_start[phase] = read_cycles())
+#define PROFILE_STOP(search,phase) \
+	do { \
+		(search)->phase_cycles[phase] += read_cycles() \
+			- (search)->phase_start[phase]; \
+		(search)->phase_calls[phase]++; \
+	} while( 0 )
+
+const char * const phase_name[NUM_PHASES] = {
+	"move generation", "make/unmake", "evaluation", "transposition table",
+	"chains", "endgame solver", "search"
+};
+uint64_t profile_cycles[NUM_PHASES];
+unsigned long profile_calls[NUM_PHASES];
+pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Move the counts of the searches into the totals */
+
+static void profile_collect( search_type * searches, unsigned int num_threads )
+{
+	unsigned int t, phase;
+
+	pthread_mutex_lock( &profile_lock );
+
+	for( t = 0; t < num_threads; t++ ) {
+
+		for( phase = 0; phase < NUM_PHASES; phase++ ) {
+			profile_cycles[phase] += searches[t].phase_cycles[phase];
+			profile_calls[phase] += searches[t].phase_calls[phase];
+			searches[t].phase_cycles[phase] = 0;
+			searches[t].phase_calls[phase] = 0;
+		} /* for */
+	} /* for */
+
+	pthread_mutex_unlock( &profile_lock );
+} /* profile_collect() */
+
+
+/* Print the share of the search's cycles that each phase took; the rest
+ * went to the recursion itself, move ordering's bookkeeping and pruning
+ */
+
+static void profile_report( void )
+{
+	uint64_t total = profile_cycles[PHASE_SEARCH], rest = total;
+	unsigned int phase;
+
+	if( total == 0 ) return;
+
+	fprintf( stderr, "\n%-20s %16s %7s %14s %10s\n", "phase", "cycles",
+		"share", "calls", "per call" );
+
+	for( phase = 0; phase < PHASE_SEARCH; phase++ ) {
+		rest -= ( profile_cycles[phase] < rest ) ? profile_cycles[phase]
+			: rest;
+		fprintf( stderr, "%-20s %16llu %6.1f%% %14lu %10.1f\n",
+			phase_name[phase], (unsigned long long)profile_cycles[phase],
+			100.0 * profile_cycles[phase] / total, profile_calls[phase],
+			( profile_calls[phase] > 0 ) ? (double)profile_cycles[phase]
+				/ profile_calls[phase] : 0.0 );
+	} /* for */
+
+	fprintf( stderr, "%-20s %16llu %6.1f%%\n", "the rest",
+		(unsigned long long)rest, 100.0 * rest / total );
+	fprintf( stderr, "%-20s %16llu %6.1f%% %14lu\n", phase_name[PHASE_SEARCH],
+		(unsigned long long)total, 100.0, profile_calls[PHASE_SEARCH] );
+} /* profile_report() */
+#else
+#define PROFILE_START(search,phase)	((void)0)
+#define PROFILE_STOP(search,phase)	((void)0)
+#endif
+
+
+/* Sort the move list best-first, by a cheap estimate of each move's worth:
+ * the transposition table's move, then the square's heuristic weight,
+ * with killer moves and then history counts breaking ties within a weight.
+ */
+
+static void order_moves( const search_type * search,
+	move_type move_list[MAX_NUM_MOVES], unsigned int num_moves,
+	const player_data_type * player, unsigned int ply, unsigned int tt_sq )
+{
+	unsigned long score[MAX_NUM_MOVES], key_score, h;
+	move_type key_move;
+	unsigned int m, n, sq;
+
+	for( m = 0; m < num_moves; m++ ) {
+		sq = move_list[m].sq;
+		h = search->history[player->id][sq];
+
+		if( sq == tt_sq ) {
+			score[m] = ~0UL;
+			continue;
+		} /* if */
+
+		score[m] = (unsigned long)square_weight[sq] << 24;
+
+		if( sq == search->killer_move[ply][0]
+			||  sq == search->killer_move[ply][1] ) {
+
+			score[m] += 1UL << 23;
+		} /* if */
+
+		score[m] += ( h < (1UL << 23) ) ? h : (1UL << 23) - 1;
+	} /* for */
+
+	/* Insertion sort; the lists are short */
+	for( m = 1; m < num_moves; m++ ) {
+		key_move = move_list[m];
+		key_score = score[m];
+
+		for( n = m; n > 0  &&  score[n - 1] < key_score; n-- ) {
+			move_list[n] = move_list[n - 1];
+			score[n] = score[n - 1];
+		} /* for */
+
+		move_list[n] = key_move;
+		score[n] = key_score;
+	} /* for */
+} /* order_moves() */
+
+
+/* Selective search (ProbCut)
+ * The value of a deep search is predicted from that of a shallow one by
+ * a linear regression, deep = a * shallow + b, with residuals of standard
+ * deviation sigma.  When a null-window shallow search shows the deep value
+ * to be at least t deviations above beta (or below alpha), the subtree is
+ * cut without the deep search.  Several pairs may be given for a depth
+ * (Multi-ProbCut); they are tried in the order of the file.  The pairs
+ * are read from a text file with a line "depth shallow a b sigma t" per
+ * pair; "#" starts a comment.  See fit_probcut() for making one.
+ */
+
+typedef struct {
+	unsigned int depth, shallow;
+	double a, b, sigma, t;
+} probcut_type;
+
+probcut_type probcut_pairs[PROBCUT_MAX_PAIRS];
+unsigned int num_probcut_pairs = 0;
+unsigned int probcut_first[MAX_PLY + 1], probcut_count[MAX_PLY + 1];
+bool probcut = FALSE;		/* Set to search selectively */
+
+
+/* Read the pairs from file_name; returns FALSE if it cannot be used */
+
+static bool load_probcut( const char * file_name )
+{
+	FILE * in = fopen( file_name, "r" );
+	probcut_type * pc, key;
+	char line[256], * comment;
+	unsigned int i, d;
+
+	if( in == NULL ) return( FALSE );
+
+	num_probcut_pairs = 0;
+
+	while( fgets( line, sizeof( line ), in ) != NULL ) {
+
+		if( ( comment = strchr( line, '#' ) ) != NULL ) {
+			*comment = '\0';
+		} /* if */
+
+		if( strspn( line, " \t\r\n" ) == strlen( line ) ) continue;
+
+		pc = &probcut_pairs[num_probcut_pairs];
+
+		if( num_probcut_pairs == PROBCUT_MAX_PAIRS
+			||  sscanf( line, "%u %u %lf %lf %lf %lf", &pc->depth,
+				&pc->shallow, &pc->a, &pc->b, &pc->sigma, &pc->t ) != 6
+			||  pc->depth > MAX_PLY  ||  pc->shallow < 1
+			||  pc->shallow >= pc->depth  ||  pc->a <= 0.0
+			||  pc->sigma < 0.0 ) {
+
+			fclose( in );
+			return( FALSE );
+		} /* if */
+
+		num_probcut_pairs++;
+	} /* while */
+
+	fclose( in );
+
+	/* Sort by depth, keeping the file's order within one; the list is short */
+	for( i = 1; i < num_probcut_pairs; i++ ) {
+		key = probcut_pairs[i];
+
+		for( d = i; d > 0  &&  probcut_pairs[d - 1].depth > key.depth; d-- ) {
+			probcut_pairs[d] = probcut_pairs[d - 1];
+		} /* for */
+
+		probcut_pairs[d] = key;
+	} /* for */
+
+	/* Index the pairs by depth */
+	memset( probcut_count, 0, sizeof( probcut_count ) );
+
+	for( i = 0; i < num_probcut_pairs; i++ ) {
+		probcut_count[probcut_pairs[i].depth]++;
+	} /* for */
+
+	for( d = 0, i = 0; d <= MAX_PLY; d++ ) {
+		probcut_first[d] = i;
+		i += probcut_count[d];
+	} /* for */
+
+	probcut = TRUE;
+	return( TRUE );
+} /* load_probcut() */
+
+
+/* The position cache (--cache) keeps the results of root searches from one
+ * run to the next, in a file that every process using it maps shared.
+ * The file is a header and a power of two of 16-byte slots; a position may
+ * sit in any of the CACHE_PROBES slots from its hash key's index on, so a
+ * lookup touches one or two pages and nothing is read or parsed when the
+ * file is opened.  A slot holds the result and the key XORed with it:
+ * a slot that another process or thread has half written fails the check
+ * and reads as empty, so readers need no lock.
+ */
+
+#define CACHE_MAGIC	"OTHC"
+#define CACHE_PROBES	4
+#define CACHE_VALID	((uint64_t)1 << 17)	/* Set in every stored result */
+
+/* How much a stored result is worth keeping: its depth, and more if exact */
+#define cache_worth(data)	(((data) & 0xFF) + (((data) >> 16 & 1) << 8))
+
+typedef struct {
+	char magic[4];			/* CACHE_MAGIC */
+	uint32_t board_size;		/* BOARD_SIZE */
+	uint64_t zobrist_check;		/* zobrist_key[0][0], as in the book */
+	uint64_t eval_check;		/* See search_check() */
+	uint64_t num_slots;		/* A power of 2 */
+} cache_header_type;
+
+typedef struct {
+	uint64_t check;			/* key ^ data */
+	uint64_t data;			/* Depth, move, exact flag and score */
+} cache_slot_type;
+
+volatile cache_slot_type * cache = NULL;	/* NULL without --cache */
+uint64_t cache_mask;
+bool cache_writable;		/* FALSE if the file could only be read */
+
+
+/* A hash of whatever changes the scores of a search: the pattern weights
+ * and the ProbCut pairs, when they are in use.  A cache made with
+ * different ones is refused.
+ */
+
+static uint64_t search_check( void )
+{
+	const unsigned char * p;
+	size_t i, size;
+	uint64_t h = 0xCBF29CE484222325;	/* FNV-1a */
+
+	if( pattern_eval ) {
+		p = (const unsigned char *)edge_weights;
+		size = ( 2 * edge_codes + corner_codes + BOARD_AREA + 1 )
+			* sizeof( int16_t );
+
+		for( i = 0; i < size; i++ ) {
+			h = ( h ^ p[i] ) * 0x100000001B3;
+		} /* for */
+	} /* if */
+
+	if( probcut ) {
+		p = (const unsigned char *)probcut_pairs;
+		size = num_probcut_pairs * sizeof( probcut_type );
+
+		for( i = 0; i < size; i++ ) {
+			h = ( h ^ p[i] ) * 0x100000001B3;
+		} /* for */
+	} /* if */
+
+	return( h );
+} /* search_check() */
+
+
+/* Map the cache, making a new one of the given number of megabytes if
+ * the file is missing or empty.  An existing file keeps its size, which
+ * must then be the one given, unless that is 0.  A file that cannot be
+ * written is used read-only.  Returns FALSE if the file cannot be used.
+ */
+
+static bool cache_open( const char * file_name, unsigned int megabytes )
+{
+	cache_header_type header;
+	struct stat st;
+	void * map;
+	uint64_t num_slots = 1, bytes;
+	int fd = open( file_name, O_RDWR | O_CREAT, 0666 );
+
+	cache_writable = ( fd >= 0 ) ? TRUE : FALSE;
+
+	if( fd < 0 ) fd = open( file_name, O_RDONLY );
+
+	if( fd < 0 ) return( FALSE );
+
+	/* Two processes must not both make the file */
+	if( flock( fd, LOCK_EX ) != 0  ||  fstat( fd, &st ) != 0 ) {
+		close( fd );
+		return( FALSE );
+	} /* if */
+
+	bytes = (uint64_t)( ( megabytes > 0 ) ? megabytes : CACHE_MEGABYTES ) << 20;
+
+	while( 2 * num_slots * sizeof( cache_slot_type ) <= bytes ) {
+		num_slots *= 2;
+	} /* while */
+
+	if( st.st_size == 0  &&  cache_writable ) {
+		memset( &header, 0, sizeof( header ) );
+		memcpy( header.magic, CACHE_MAGIC, 4 );
+		header.board_size = BOARD_SIZE;
+		header.zobrist_check = zobrist_key[0][0];
+		header.eval_check = search_check();
+		header.num_slots = num_slots;
+		st.st_size = sizeof( header ) + num_slots * sizeof( cache_slot_type );
+
+		/* The slots are a hole in the file, read as zeros (empty) */
+		if( ftruncate( fd, st.st_size ) != 0
+			||  pwrite( fd, &header, sizeof( header ), 0 )
+				!= (ssize_t)sizeof( header ) ) {
+
+			close( fd );
+			return( FALSE );
+		} /* if */
+	} /* if */
+
+	if( (size_t)st.st_size < sizeof( header )
+		||  pread( fd, &header, sizeof( header ), 0 )
+			!= (ssize_t)sizeof( header )
+		||  memcmp( header.magic, CACHE_MAGIC, 4 ) != 0
+		||  header.board_size != BOARD_SIZE
+		||  header.zobrist_check != zobrist_key[0][0]
+		||  header.eval_check != search_check()
+		||  header.num_slots == 0
+		||  ( header.num_slots & ( header.num_slots - 1 ) ) != 0
+		||  (uint64_t)st.st_size != sizeof( header )
+			+ header.num_slots * sizeof( cache_slot_type ) ) {
+
+		close( fd );
+		return( FALSE );
+	} /* if */
+
+	if( megabytes > 0  &&  header.num_slots != num_slots ) {
+		fprintf( stderr, "%s is a cache of %lu megabytes, not %u\n", file_name,
+			(unsigned long)( ( header.num_slots
+				* sizeof( cache_slot_type ) ) >> 20 ), megabytes );
+		close( fd );
+		return( FALSE );
+	} /* if */
+
+	map = mmap( NULL, st.st_size, cache_writable ? PROT_READ | PROT_WRITE
+		: PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );		/* Also drops the lock */
+
+	if( map == MAP_FAILED ) return( FALSE );
+
+	/* Left mapped until the program exits; the system writes it back */
+	cache = (volatile cache_slot_type *)( (cache_header_type *)map + 1 );
+	cache_mask = header.num_slots - 1;
+	return( TRUE );
+} /* cache_open() */
+
+
+/* Find a position in the cache; return FALSE if it is not there */
+
+static bool cache_probe( uint64_t key, search_result_type * result )
+{
+	volatile cache_slot_type * slot;
+	uint64_t data;
+	unsigned int i;
+
+	for( i = 0; i < CACHE_PROBES; i++ ) {
+		slot = &cache[( key + i ) & cache_mask];
+		data = slot->data;
+
+		if( ( data & CACHE_VALID ) != 0  &&  ( slot->check ^ data ) == key ) {
+			result->depth = (unsigned int)( data & 0xFF );
+			result->pv.move[0] = (uint8_t)( data >> 8 );
+			result->pv.length = ( result->pv.move[0] != NO_MOVE ) ? 1 : 0;
+			result->exact = ( ( data >> 16 ) & 1 ) ? TRUE : FALSE;
+			result->partial = FALSE;
+			result->score = (int16_t)( data >> 32 );
+			return( TRUE );
+		} /* if */
+	} /* for */
+
+	return( FALSE );
+} /* cache_probe() */
+
+
+/* Record the result of a root search.  An exact or deeper result already
+ * there for the position is kept.  Otherwise the result goes in the
+ * position's own slot, or else in the one with the least worth keeping:
+ * an empty one, or the shallowest, exact results counting above all others.
+ */
+
+static void cache_store( uint64_t key, const search_result_type * result )
+{
+	volatile cache_slot_type * slot, * victim = NULL;
+	uint64_t data, old;
+	unsigned int i, worth, victim_worth = 0;
+
+	if( !cache_writable  ||  result->depth == 0  ||  result->partial ) return;
+
+	data = CACHE_VALID | ( result->depth & 0xFF )
+		| (uint64_t)( ( result->pv.length > 0 ) ? result->pv.move[0]
+			: NO_MOVE ) << 8
+		| (uint64_t)( result->exact ? 1 : 0 ) << 16
+		| (uint64_t)(uint16_t)result->score << 32;
+
+	for( i = 0; i < CACHE_PROBES; i++ ) {
+		slot = &cache[( key + i ) & cache_mask];
+		old = slot->data;
+
+		if( ( old & CACHE_VALID ) == 0 ) {
+			worth = 0;
+		} else {
+			worth = (unsigned int)cache_worth( old );
+
+			if( ( slot->check ^ old ) == key ) {
+
+				if( worth >= cache_worth( data ) ) return;
+
+				victim = slot;
+				break;
+			} /* if */
+		} /* if */
+
+		if( victim == NULL  ||  worth < victim_worth ) {
+			victim = slot;
+			victim_worth = worth;
+		} /* if */
+	} /* for */
+
+	/* A reader that sees only one of the two words finds no match */
+	victim->data = data;
+	victim->check = key ^ data;
+} /* cache_store() */
+
+
+/* Count a node toward the next look at the stop flag and the clock, and
+ * mark the search aborted if it is time to end it.  The countdown is kept
+ * apart from the node counts, which are only statistics.
+ */
+
+static void check_stop( search_type * search )
+{
+	if( --search->clock_countdown > 0 ) return;
+
+	search->clock_countdown = CLOCK_CHECK_INTERVAL;
+
+	if( *search->stop  ||  ( search->deadline > 0.0
+		&&  now_seconds() >= search->deadline ) ) {
+
+		search->aborted = TRUE;
+	} /* if */
+} /* check_stop() */
+
+
+/* Compute the best-move chain (according to the minimax algorithm)
+ * and leave it in search->pv[ply].
+ * The value of a position is the best, over its moves, of the move's
+ * effect less the value of the position it leads to (negamax).  Only
+ * values inside the window (alpha, beta) are exact: a search that fails
+ * high returns a lower bound >= beta, and one that fails low an upper
+ * bound <= alpha.  The first move is searched with the full window and
+ * the others with a null window, just to show that they are no better,
+ * with a full search only for a move that turns out better after all
+ * (principal variation search).  At the root, a move that ties the best
+ * so far is searched exactly too, so that ties can be broken at random.
+ * The transposition table can end the search of a position early, in which
+ * case the chain holds only the stored best move.
+ * If the deadline passes or *search->stop is set, search->aborted is set and
+ * the search unwinds, leaving an empty chain.
+ */
+
+static int best_move( search_type * search, player_data_type * player,
+	unsigned int ply, unsigned int max_ply, int alpha, int beta )
+{
+	move_type * move_list;
+	int effect, gain, bound, score, max_effect = INIT_MAX_EFFECT,
+		alpha_in = alpha;
+	unsigned int num_moves, m, i, num_best_moves = 0,
+		depth = max_ply - ply + 1;
+	const probcut_type * pc;
+	tt_entry_type entry;
+	bool found, leaf;
+	uint64_t node_key;
+#ifdef TRACE
+	double node_start = now_seconds();
+#endif
+
+	search->pv_length[ply] = 0;
+
+	if( ply == 1 ) {
+		search->hash_key = hash_position( player );
+	} /* if */
+
+	search->stats.node_count++;
+	check_stop( search );
+
+	if( search->aborted ) return( 0 );
+
+	search->stats.ply_nodes[ply]++;
+	search->stats.tt_probes++;
+	node_key = search->hash_key;
+	PROFILE_START( search, PHASE_TT );
+	found = tt_probe( search->tt, node_key, &entry );
+	PROFILE_STOP( search, PHASE_TT );
+
+	if( found ) {
+		search->stats.tt_hits++;
+	} /* if */
+
+	if( found  &&  ply > 1  &&  entry.depth >= depth
+		&&  ( entry.bound == TT_EXACT
+			||  ( entry.bound == TT_LOWER  &&  entry.score >= beta )
+			||  ( entry.bound == TT_UPPER  &&  entry.score <= alpha ) ) ) {
+
+		/* The stored result is good enough; its best move is the chain */
+		search->stats.tt_cuts++;
+
+		if( entry.move != NO_MOVE ) {
+			search->pv[ply][0] = entry.move;
+			search->pv_length[ply] = 1;
+		} /* if */
+
+		return( entry.score );
+	} /* if */
+
+	/* ProbCut: let shallow searches decide whether the deep one is needed */
+	if( probcut  &&  ply > 1  &&  depth <= MAX_PLY ) {
+
+		for( i = probcut_first[depth];
+			i < probcut_first[depth] + probcut_count[depth]; i++ ) {
+
+			pc = &probcut_pairs[i];
+
+			if( beta < -INIT_MAX_EFFECT ) {
+				bound = (int)ceil( ( beta + pc->t * pc->sigma - pc->b ) / pc->a );
+				score = best_move( search, player, ply, ply + pc->shallow - 1,
+					bound - 1, bound );
+
+				if( search->aborted ) return( 0 );
+
+				if( score >= bound ) {
+					search->stats.probcut_cuts++;
+					return( beta );
+				} /* if */
+			} /* if */
+
+			if( alpha > INIT_MAX_EFFECT ) {
+				bound = (int)floor( ( alpha - pc->t * pc->sigma - pc->b )
+					/ pc->a );
+				score = best_move( search, player, ply, ply + pc->shallow - 1,
+					bound, bound + 1 );
+
+				if( search->aborted ) return( 0 );
+
+				if( score <= bound ) {
+					search->stats.probcut_cuts++;
+					return( alpha );
+				} /* if */
+			} /* if */
+		} /* for */
+
+		search->pv_length[ply] = 0;
+	} /* if */
+
+	PROFILE_START( search, PHASE_MOVES );
+	move_list = &search->move_stack[search->move_sp];
+	num_moves = generate_moves( player, move_list );
+	search->move_sp += num_moves;
+	order_moves( search, move_list, num_moves, player, ply,
+		found ? entry.move : NO_MOVE );
+	PROFILE_STOP( search, PHASE_MOVES );
+
+	for( m = 0; m < num_moves; m++ ) {
+		/* Make and record changes */
+		PROFILE_START( search, PHASE_MAKE );
+		gain = make_move( search, player, &move_list[m] );
+		PROFILE_STOP( search, PHASE_MAKE );
+		search->pv_length[ply + 1] = 0;
+		leaf = ( ply >= max_ply
+			||  player->count + player->opponent->count == BOARD_AREA );
+
+		if( pattern_eval ) {
+			/* Only the leaves are scored, so the search is plain minimax */
+			PROFILE_START( search, PHASE_EVAL );
+			gain = leaf ? pattern_score( player ) : 0;
+			PROFILE_STOP( search, PHASE_EVAL );
+		} /* if */
+
+		TRACE_PRINT( search, ( "Ply %d: %c placed at (%d,%d)\n", ply,
+			player->marker, move_list[m].sq / BOARD_SIZE,
+			move_list[m].sq % BOARD_SIZE ) );
+
+		if( leaf ) {
+			effect = gain;
+		} else if( m == 0 ) {
+			effect = gain - best_move( search, player->opponent,
+				ply + 1, max_ply, gain - beta, gain - alpha );
+		} else {
+			/* Is the move better than alpha (or, at the root, as good
+			 * as the best so far)?
+			 */
+			bound = ( ply == 1  &&  alpha == max_effect ) ? alpha - 1 : alpha;
+			effect = gain - best_move( search, player->opponent,
+				ply + 1, max_ply, gain - bound - 1, gain - bound );
+
+			if( effect > bound  &&  effect < beta  &&  !search->aborted ) {
+				search->pv_length[ply + 1] = 0;
+				effect = gain - best_move( search, player->opponent,
+					ply + 1, max_ply, gain - beta, gain - bound );
+			} /* if */
+		} /* if */
+
+		/* Remove marker and undo changes */
+		PROFILE_START( search, PHASE_MAKE );
+		unmake_move( search, player );
+		PROFILE_STOP( search, PHASE_MAKE );
+
+		if( search->aborted ) break;
+
+		/* Choose among equally good root moves at random: the k-th of
+		 * them replaces the chain so far with probability 1/k
+		 */
+		if( effect > max_effect  ||  ( ply == 1  &&  effect == max_effect
+			&&  search_rand( search ) % ( num_best_moves + 1 ) == 0 ) ) {
+
+			num_best_moves = ( effect > max_effect ) ? 1 : num_best_moves + 1;
+			max_effect = effect;
+			PROFILE_START( search, PHASE_PV );
+			search->pv[ply][0] = (uint8_t)move_list[m].sq;
+			memcpy( &search->pv[ply][1], search->pv[ply + 1],
+				search->pv_length[ply + 1] );
+			search->pv_length[ply] = search->pv_length[ply + 1] + 1;
+
+			/* A root move shown to be inside the window or above it is
+			 * the result, should the iteration be cut short
+			 */
+			if( ply == 1  &&  effect > alpha_in ) {
+				search->partial.length = search->pv_length[1];
+				memcpy( search->partial.move, search->pv[1],
+					search->pv_length[1] );
+				search->partial_score = effect;
+			} /* if */
+
+			PROFILE_STOP( search, PHASE_PV );
+		} else if( effect == max_effect ) {
+			num_best_moves++;
+		} /* if */
+
+		if( max_effect > alpha ) {
+			alpha = max_effect;
+		} /* if */
+
+		if( alpha >= beta ) {
+			/* Alpha-beta pruning is done here */
+			TRACE_PRINT( search, ( "prune: %d >= %d\n", alpha, beta ) );
+			search->stats.cutoff_count++;
+
+			if( m == 0 ) {
+				search->stats.first_move_cutoffs++;
+			} /* if */
+
+			if( search->killer_move[ply][0] != move_list[m].sq ) {
+				search->killer_move[ply][1] = search->killer_move[ply][0];
+				search->killer_move[ply][0] = move_list[m].sq;
+			} /* if */
+
+			search->history[player->id][move_list[m].sq] += depth * depth;
+			break;
+		} /* if */
+	} /* for */
+
+	search->move_sp -= num_moves;
+
+	if( search->aborted ) {
+		search->pv_length[ply] = 0;
+		return( 0 );
+	} /* if */
+
+	if( num_moves == 0 ) {
+		TRACE_PRINT( search, ( "Ply %d: no best move chosen\n", ply ) );
+		max_effect = pattern_eval ? -pattern_score( player->opponent ) : 0;
+	} /* if */
+
+#ifdef TRACE
+	if( search->verbose  &&  num_moves > 0 ) {
+		trace_node( search, player, ply, num_best_moves, max_effect,
+			now_seconds() - node_start );
+	} /* if */
+#endif
+
+	PROFILE_START( search, PHASE_TT );
+	tt_store( search->tt, node_key, depth, ( num_moves == 0 ) ? TT_EXACT
+		: ( max_effect >= beta ) ? TT_LOWER
+		: ( max_effect <= alpha_in ) ? TT_UPPER : TT_EXACT,
+		max_effect, ( num_moves > 0 ) ? search->pv[ply][0] : NO_MOVE );
+	PROFILE_STOP( search, PHASE_TT );
+	return( max_effect );
+} /* best_move() */
+
+
+/* Exact endgame solver
+ * With few empty squares left, the game is played out to the end and
+ * scored by the final disc differential rather than by h_func().
+ * These routines work on bare bitboards; "mine" is the side to move.
+ */
+
+#define FINAL_SCORE(mine,theirs)	((int)bit_count(mine) - (int)bit_count(theirs))
+
+/* Set up the neighbour and quadrant tables used by the solver */
+
+static void init_endgame( void )
+{
+	unsigned int sq, i;
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+		neighbours[sq] = 0;
+
+		for( i = 0; i < NUM_VECTORS; i++ ) {
+			neighbours[sq] |= shift_bits( SQUARE_BIT(sq), i );
+		} /* for */
+
+		quadrant_of[sq] = ( sq / BOARD_SIZE >= BOARD_SIZE / 2 ) * 2
+			+ ( sq % BOARD_SIZE >= BOARD_SIZE / 2 );
+		quadrant_mask[quadrant_of[sq]] |= SQUARE_BIT(sq);
+	} /* for */
+} /* init_endgame() */
+
+
+/* The last empty square: whoever can move there does */
+
+static int solve_last1( search_type * search, bitboard_type mine,
+	bitboard_type theirs, unsigned int sq )
+{
+	int score = FINAL_SCORE( mine, theirs );
+	unsigned int n;
+
+	search->stats.node_count++;
+
+	if( ( neighbours[sq] & theirs ) != 0
+		&&  ( n = bit_count( compute_flips( sq, mine, theirs ) ) ) != 0 ) {
+
+		return( score + 2 * n + 1 );
+	} /* if */
+
+	if( ( neighbours[sq] & mine ) != 0
+		&&  ( n = bit_count( compute_flips( sq, theirs, mine ) ) ) != 0 ) {
+
+		return( score - 2 * n - 1 );
+	} /* if */
+
+	return( score );
+} /* solve_last1() */
+
+
+/* Two to four empty squares, given in the order to try them.
+ * No move list is built: each square is tested directly, and skipped
+ * at once unless an opposing marker is next to it.
+ */
+
+static int solve_last4( search_type * search, bitboard_type mine,
+	bitboard_type theirs, int alpha, int beta,
+	const unsigned int empty_sq[4], unsigned int num_empty, bool passed )
+{
+	bitboard_type flips;
+	unsigned int rest[4], i, k, n;
+	int score, best = -BOARD_AREA - 1;
+
+	search->stats.node_count++;
+
+	for( i = 0; i < num_empty; i++ ) {
+
+		if( ( neighbours[empty_sq[i]] & theirs ) == 0 ) continue;
+
+		flips = compute_flips( empty_sq[i], mine, theirs );
+
+		if( flips == 0 ) continue;
+
+		for( k = n = 0; k < num_empty; k++ ) {
+
+			if( k != i ) {
+				rest[n++] = empty_sq[k];
+			} /* if */
+		} /* for */
+
+		if( n == 1 ) {
+			score = -solve_last1( search, theirs & ~flips,
+				mine | flips | SQUARE_BIT( empty_sq[i] ), rest[0] );
+		} else {
+			score = -solve_last4( search, theirs & ~flips,
+				mine | flips | SQUARE_BIT( empty_sq[i] ), -beta, -alpha,
+				rest, n, FALSE );
+		} /* if */
+
+		if( score > best ) {
+			best = score;
+
+			if( best > alpha ) {
+				alpha = best;
+
+				if( alpha >= beta ) break;
+			} /* if */
+		} /* if */
+	} /* for */
+
+	if( best == -BOARD_AREA - 1 ) {	/* No move */
+
+		if( passed ) return( FINAL_SCORE( mine, theirs ) );
+
+		best = -solve_last4( search, theirs, mine, -beta, -alpha,
+			empty_sq, num_empty, TRUE );
+	} /* if */
+
+	return( best );
+} /* solve_last4() */
+
+
+/* Solve the position exactly, leaving the best line in search->pv[ply].
+ * Moves into quadrants holding an odd number of empty squares are tried
+ * first, since the side that moves last in a region tends to gain there;
+ * with many empty squares left, moves leaving the opponent fewest replies
+ * come before that.
+ */
+
+static int solve( search_type * search, bitboard_type mine,
+	bitboard_type theirs, int alpha, int beta, unsigned int ply, bool passed )
+{
+	bitboard_type empty = FULL_BOARD & ~(mine | theirs), moves, b;
+	move_type * move_list, key_move;
+	uint8_t order[MAX_NUM_MOVES], key_order;
+	int score, best = -BOARD_AREA - 1;
+	unsigned int empty_sq[4], num_empty = bit_count( empty ), num_moves = 0,
+		m, n, q, odd;
+
+	search->pv_length[ply] = 0;
+
+	search->stats.node_count++;
+	check_stop( search );
+
+	if( search->aborted ) return( 0 );
+
+	search->stats.ply_nodes[ply]++;
+
+	if( num_empty == 0 ) return( FINAL_SCORE( mine, theirs ) );
+
+	/* Below the root, which must record its move, the last few squares
+	 * are left to the specialized routines
+	 */
+	if( num_empty == 1  &&  ply > 1 ) {
+		return( solve_last1( search, mine, theirs, first_bit( empty ) ) );
+	} /* if */
+
+	if( num_empty <= 4  &&  ply > 1 ) {
+		/* Odd quadrants first, then even ones */
+		for( odd = 2, n = 0; odd-- > 0; ) {
+
+			for( q = 0; q < 4; q++ ) {
+
+				if( ( bit_count( empty & quadrant_mask[q] ) & 1 ) != odd ) continue;
+
+				for( b = empty & quadrant_mask[q]; b != 0; b &= b - 1 ) {
+					empty_sq[n++] = first_bit( b );
+				} /* for */
+			} /* for */
+		} /* for */
+
+		return( solve_last4( search, mine, theirs, alpha, beta, empty_sq,
+			num_empty, passed ) );
+	} /* if */
+
+	move_list = &search->move_stack[search->move_sp];
+
+	for( moves = legal_moves( mine, theirs ); moves != 0; moves &= moves - 1 ) {
+		m = num_moves++;
+		move_list[m].sq = first_bit( moves );
+		move_list[m].flips = compute_flips( move_list[m].sq, mine, theirs );
+		order[m] = ( bit_count( empty & quadrant_mask[quadrant_of[move_list[m].sq]] )
+			& 1 ) ? 0 : 1;
+
+		if( num_empty > ENDGAME_FASTEST_FIRST ) {
+			order[m] += 2 * bit_count( legal_moves( theirs & ~move_list[m].flips,
+				mine | move_list[m].flips | SQUARE_BIT( move_list[m].sq ) ) );
+		} /* if */
+	} /* for */
+
+	if( num_moves == 0 ) {
+
+		if( passed ) return( FINAL_SCORE( mine, theirs ) );
+
+		/* Pass; the chain stops here, as in best_move() */
+		return( -solve( search, theirs, mine, -beta, -alpha, ply + 1, TRUE ) );
+	} /* if */
+
+	/* Insertion sort, lowest order first */
+	for( m = 1; m < num_moves; m++ ) {
+		key_move = move_list[m];
+		key_order = order[m];
+
+		for( n = m; n > 0  &&  order[n - 1] > key_order; n-- ) {
+			move_list[n] = move_list[n - 1];
+			order[n] = order[n - 1];
+		} /* for */
+
+		move_list[n] = key_move;
+		order[n] = key_order;
+	} /* for */
+
+	search->move_sp += num_moves;
+
+	for( m = 0; m < num_moves; m++ ) {
+		score = -solve( search, theirs & ~move_list[m].flips,
+			mine | move_list[m].flips | SQUARE_BIT( move_list[m].sq ),
+			-beta, -alpha, ply + 1, FALSE );
+
+		if( search->aborted ) break;
+
+		if( score > best ) {
+			best = score;
+			search->pv[ply][0] = (uint8_t)move_list[m].sq;
+			memcpy( &search->pv[ply][1], search->pv[ply + 1],
+				search->pv_length[ply + 1] );
+			search->pv_length[ply] = search->pv_length[ply + 1] + 1;
+
+			if( best > alpha ) {
+				alpha = best;
+
+				if( alpha >= beta ) {
+					search->stats.cutoff_count++;
+
+					if( m == 0 ) {
+						search->stats.first_move_cutoffs++;
+					} /* if */
+
+					break;
+				} /* if */
+			} /* if */
+		} /* if */
+	} /* for */
+
+	search->move_sp -= num_moves;
+	return( search->aborted ? 0 : best );
+} /* solve() */
+
+
+/* Give a search its own copy of the position, with the given player
+ * to move, and clear what it learned about the previous position
+ */
+
+static void start_search( search_type * search,
+	const player_data_type * player, unsigned int max_ply )
+{
+	unsigned int i;
+
+	search->players[player->id] = *player;
+	search->players[player->opponent->id] = *player->opponent;
+	search->players[0].opponent = &search->players[1];
+	search->players[1].opponent = &search->players[0];
+	search->root_id = player->id;
+	search->max_ply = max_ply;
+	search->aborted = FALSE;
+	search->clock_countdown = CLOCK_CHECK_INTERVAL;
+	search->move_sp = search->undo_sp = 0;
+	memset( &search->stats, 0, sizeof( search->stats ) );
+
+	/* Killers are specific to this position; history fades over the game */
+	for( i = 0; i <= MAX_PLY; i++ ) {
+		search->killer_move[i][0] = search->killer_move[i][1] = NO_MOVE;
+	} /* for */
+
+	for( i = 0; i < BOARD_AREA; i++ ) {
+		search->history[0][i] /= 2;
+		search->history[1][i] /= 2;
+	} /* for */
+} /* start_search() */
+
+
+/* A helper thread deepens its own search of the root until it reaches
+ * max_ply or is stopped.  Only its transposition table entries are used.
+ */
+
+static void * helper_thread( void * arg )
+{
+	search_type * search = (search_type *)arg;
+	player_data_type * player = &search->players[search->root_id];
+	unsigned int depth, num_empty = BOARD_AREA - player->count
+		- player->opponent->count;
+
+	PROFILE_START( search, PHASE_SEARCH );
+
+	for( depth = search->start_depth;
+		depth <= search->max_ply  &&  depth <= num_empty; depth++ ) {
+
+		best_move( search, player, 1, depth, INIT_MAX_EFFECT,
+			-INIT_MAX_EFFECT );
+
+		if( search->aborted ) break;
+	} /* for */
+
+	PROFILE_STOP( search, PHASE_SEARCH );
+	return( NULL );
+} /* helper_thread() */
+
+
+/* Take the result of a root search from the cache, if it has one that
+ * is as good as the search would give: solved exactly, or, with no time
+ * budget and the position outside the solver's range, searched at least
+ * to max_ply (or to the end of the game).  The stored move must be legal,
+ * in case of a clash of hash keys.  The searches' counters are reset as
+ * if they had searched.
+ */
+
+static bool cache_lookup( search_type * searches, unsigned int num_threads,
+	const player_data_type * player, unsigned int max_ply, double movetime,
+	search_result_type * result )
+{
+	bitboard_type moves = legal_moves( player->discs,
+		player->opponent->discs );
+	unsigned int t, num_empty = BOARD_AREA - player->count
+		- player->opponent->count;
+
+	if( !cache_probe( hash_position( player ), result ) ) return( FALSE );
+
+	if( !result->exact  &&  ( movetime > 0.0  ||  num_empty <= endgame_empties
+		||  result->depth < ( ( max_ply < num_empty ) ? max_ply
+			: num_empty ) ) ) {
+
+		return( FALSE );
+	} /* if */
+
+	if( ( result->pv.length > 0 ) ? ( moves & SQUARE_BIT(
+		result->pv.move[0] ) ) == 0 : moves != 0 ) {
+
+		return( FALSE );
+	} /* if */
+
+	for( t = 0; t < num_threads; t++ ) {
+		memset( &searches[t].stats, 0, sizeof( searches[t].stats ) );
+	} /* for */
+
+	searches[0].stats.cache_hits = 1;
+	return( TRUE );
+} /* cache_lookup() */
+
+
+/* Iterative deepening driver for best_move().
+ * Searches to depth 1, 2, ... max_ply, and returns the chain and effect of
+ * the last iteration to complete.  Positions with endgame_empties or fewer
+ * empty squares are solved exactly instead, unless the time runs out.
+ * The search can be ended at any time, by a movetime (in seconds) greater
+ * than zero running out or by another thread setting the flag that
+ * searches[0].interrupt points at, if not NULL; the flag and the clock are
+ * looked at every CLOCK_CHECK_INTERVAL nodes (see check_stop()).  The
+ * result is then that of the last iteration to complete, unless the one
+ * cut short had already found a root move that beats the window around
+ * that result: then its chain and score are returned, with
+ * result->partial set.  A position is
+ * always given a move, if it has one.  No new iteration is begun once
+ * half of the movetime is gone, since it would most likely not finish.
+ * Ties are broken from searches[0].rand_state.
+ * searches[0] is used by the calling thread; the other num_threads - 1
+ * records run helper threads on the same position for as long as it
+ * searches, half of them one ply ahead of it.  With --cache, a result
+ * that cache_lookup() accepts is returned without searching, and the
+ * result of every search is stored.
+ */
+
+static int search_root( search_type * searches, unsigned int num_threads,
+	const player_data_type * player, unsigned int max_ply, double movetime,
+	search_result_type * result )
+{
+	search_type * search = &searches[0];
+	player_data_type * root;
+	bitboard_type moves;
+	double start = now_seconds();
+	int effect, alpha, beta, delta;
+	unsigned int depth, t, num_empty = BOARD_AREA - player->count
+		- player->opponent->count;
+
+	if( cache != NULL  &&  cache_lookup( searches, num_threads, player,
+		max_ply, movetime, result ) ) {
+
+		return( result->score );
+	} /* if */
+
+	result->score = 0;
+	result->exact = FALSE;
+	result->depth = 0;
+	result->partial = FALSE;
+	result->pv.length = 0;
+	search->stop_requested = FALSE;
+	search->stop = ( search->interrupt != NULL ) ? search->interrupt
+		: &search->stop_requested;
+	PROFILE_START( search, PHASE_SEARCH );
+
+	if( num_empty <= endgame_empties ) {
+		start_search( search, player, max_ply );
+		search->deadline = ( movetime > 0.0 ) ? start + movetime : 0.0;
+		search->verbose = verbose;
+		root = &search->players[search->root_id];
+		PROFILE_START( search, PHASE_SOLVE );
+		effect = solve( search, root->discs, root->opponent->discs,
+			-BOARD_AREA - 1, BOARD_AREA + 1, 1, FALSE );
+		PROFILE_STOP( search, PHASE_SOLVE );
+
+		if( !search->aborted ) {
+			result->score = effect;
+			result->exact = TRUE;
+			result->depth = num_empty;
+			result->pv.length = search->pv_length[1];
+			memcpy( result->pv.move, search->pv[1], result->pv.length );
+
+			if( cache != NULL ) cache_store( hash_position( player ), result );
+
+#ifdef PROFILE
+			PROFILE_STOP( search, PHASE_SEARCH );
+			profile_collect( searches, 1 );
+#endif
+			return( effect );
+		} /* if */
+
+		/* Out of time: fall back on the heuristic search */
+	} /* if */
+
+	/* Entries from earlier searches are the first to be replaced.  Once
+	 * the generations stored wrap around, an isolated table's old entries
+	 * would read as current, so it is cleared.
+	 */
+	if( ( ++search->tt->generation & TT_GENERATIONS ) == 0
+		&&  search->tt->isolated ) {
+
+		tt_clear( search->tt );
+	} /* if */
+
+	for( t = 0; t < num_threads; t++ ) {
+		start_search( &searches[t], player, max_ply );
+		searches[t].start_depth = 1 + t % 2;
+		searches[t].deadline = ( movetime > 0.0 ) ? start + movetime : 0.0;
+		searches[t].verbose = ( t == 0 ) ? verbose : FALSE;
+
+		if( t > 0 ) {
+			searches[t].stop = &search->stop_requested;
+			searches[t].rand_state = search_rand( search );
+		} /* if */
+
+		if( t > 0  &&  pthread_create( &searches[t].thread, NULL,
+			helper_thread, &searches[t] ) != 0 ) {
+
+			fprintf( stderr, "Cannot start search thread %d\n", t );
+			exit( 1 );
+		} /* if */
+	} /* for */
+
+	root = &search->players[search->root_id];
+
+	for( depth = 1; depth <= max_ply; depth++ ) {
+		/* Expect the score of the last iteration, and widen the window
+		 * on whichever side the search fails
+		 */
+		delta = ASPIRATION_WINDOW;
+		alpha = ( depth > 1 ) ? result->score - delta : INIT_MAX_EFFECT;
+		beta = ( depth > 1 ) ? result->score + delta : -INIT_MAX_EFFECT;
+		search->partial.length = 0;
+
+		for( ; ; ) {
+			effect = best_move( search, root, 1, depth, alpha, beta );
+
+			if( search->aborted ) break;
+
+			if( effect <= alpha  &&  alpha > INIT_MAX_EFFECT ) {
+				alpha = ( effect - delta > INIT_MAX_EFFECT ) ? effect - delta
+					: INIT_MAX_EFFECT;
+			} else if( effect >= beta  &&  beta < -INIT_MAX_EFFECT ) {
+				beta = ( effect + delta < -INIT_MAX_EFFECT ) ? effect + delta
+					: -INIT_MAX_EFFECT;
+			} else {
+				break;
+			} /* if */
+
+			search->stats.research_count++;
+			delta *= 4;
+		} /* for */
+
+		if( search->aborted  &&  search->partial.length > 0 ) {
+			result->pv = search->partial;
+			result->score = search->partial_score;
+			result->partial = TRUE;
+		} /* if */
+
+		if( search->aborted ) break;
+
+		result->pv.length = search->pv_length[1];
+		memcpy( result->pv.move, search->pv[1], result->pv.length );
+		result->depth = depth;
+		result->score = effect;
+
+		if( search->verbose ) {
+			printf( "Depth %d: effect %d after %.3f seconds\n", depth, effect,
+				now_seconds() - start );
+		} /* if */
+
+		if( depth >= num_empty ) break;	/* Searched to the end of the game */
+
+		if( movetime > 0.0  &&  now_seconds() - start >= movetime / 2 ) break;
+	} /* for */
+
+	search->stop_requested = TRUE;
+
+	/* Stopped before depth 1 was done: any legal move will do */
+	if( result->pv.length == 0 ) {
+		moves = legal_moves( root->discs, root->opponent->discs );
+
+		if( moves != 0 ) {
+			result->pv.move[0] = (uint8_t)first_bit( moves );
+			result->pv.length = 1;
+			result->partial = TRUE;
+		} /* if */
+	} /* if */
+
+	for( t = 1; t < num_threads; t++ ) {
+		pthread_join( searches[t].thread, NULL );
+	} /* for */
+
+	if( cache != NULL ) cache_store( hash_position( player ), result );
+
+#ifdef PROFILE
+	PROFILE_STOP( search, PHASE_SEARCH );
+	profile_collect( searches, num_threads );
+#endif
+	return( result->score );
+} /* search_root() */
+
+
+/* Add up the counters of all the threads of a search */
+
+static void sum_stats( const search_type * searches, unsigned int num_threads,
+	search_stats_type * total )
+{
+	unsigned int t, ply;
+
+	memset( total, 0, sizeof( *total ) );
+
+	for( t = 0; t < num_threads; t++ ) {
+		total->node_count += searches[t].stats.node_count;
+		total->cutoff_count += searches[t].stats.cutoff_count;
+		total->first_move_cutoffs += searches[t].stats.first_move_cutoffs;
+		total->tt_probes += searches[t].stats.tt_probes;
+		total->tt_hits += searches[t].stats.tt_hits;
+		total->tt_cuts += searches[t].stats.tt_cuts;
+		total->research_count += searches[t].stats.research_count;
+		total->probcut_cuts += searches[t].stats.probcut_cuts;
+		total->cache_hits += searches[t].stats.cache_hits;
+
+		for( ply = 0; ply < MAX_LINE; ply++ ) {
+			total->ply_nodes[ply] += searches[t].stats.ply_nodes[ply];
+		} /* for */
+	} /* for */
+} /* sum_stats() */
+
+
+/* Write one search's counters as a line of JSON.
+ * The move is [row,column], or as in print_analysis(), "pass" for a side
+ * with no legal move and "none" for a finished game.  ply_nodes counts the nodes of best_move() and solve() at each ply from
+ * the root (ply 1) down; the nodes of the last-four solver are included
+ * only in the total.
+ */
+
+static void print_stats( FILE * out, const search_stats_type * stats,
+	const player_data_type * player, const search_result_type * result,
+	double elapsed )
+{
+	unsigned int ply, last_ply;
+	char move[16];
+
+	if( result->pv.length > 0 ) {
+		sprintf( move, "[%d,%d]", result->pv.move[0] / BOARD_SIZE,
+			result->pv.move[0] % BOARD_SIZE );
+	} else {
+		strcpy( move, result->exact ? "\"none\"" : "\"pass\"" );
+	} /* if */
+
+	fprintf( out, "{\"player\":\"%c\",\"empties\":%u,\"move\":%s,"
+		"\"score\":%d,\"exact\":%s,\"depth\":%u,\"partial\":%s,"
+		"\"time\":%.6f,"
+		"\"nodes\":%lu,\"nps\":%.0f,\"cutoffs\":%lu,"
+		"\"first_move_cutoffs\":%lu,\"first_move_cutoff_rate\":%.4f,"
+		"\"tt_probes\":%lu,\"tt_hits\":%lu,\"tt_cuts\":%lu,"
+		"\"researches\":%lu,\"probcut_cuts\":%lu,\"cache_hits\":%lu,"
+		"\"ply_nodes\":[",
+		player->marker, BOARD_AREA - player->count - player->opponent->count,
+		move, result->score, result->exact ? "true" : "false", result->depth,
+		result->partial ? "true" : "false", elapsed, stats->node_count,
+		( elapsed > 0.0 ) ? stats->node_count / elapsed : 0.0,
+		stats->cutoff_count, stats->first_move_cutoffs,
+		( stats->cutoff_count > 0 )
+			? (double)stats->first_move_cutoffs / stats->cutoff_count : 0.0,
+		stats->tt_probes, stats->tt_hits, stats->tt_cuts,
+		stats->research_count, stats->probcut_cuts, stats->cache_hits );
+
+	for( last_ply = MAX_LINE - 1; last_ply > 1
+		&&  stats->ply_nodes[last_ply] == 0; last_ply-- ) {
+	} /* for */
+
+	for( ply = 1; ply <= last_ply; ply++ ) {
+		fprintf( out, ( ply > 1 ) ? ",%lu" : "%lu", stats->ply_nodes[ply] );
+	} /* for */
+
+	fprintf( out, "]}\n" );
+	fflush( out );
+} /* print_stats() */
+
+
+/* Pondering ("--ponder")
+ * While the human thinks, a background thread searches the position after
+ * the reply the computer expects, the second move of the chain it just
+ * played, as if that reply had been made.  If the position the computer
+ * then has to move in is the one pondered, that search is left to finish
+ * and its result is played at once; if not, it is stopped.
+ * Either way, what it stored in the transposition table stays.
+ */
+
+typedef struct {
+	search_type * searches;
+	unsigned int num_threads, max_ply;
+	double movetime;
+	player_data_type players[2];	/* The position being pondered */
+	unsigned int mover_id;		/* The id of the player to move in it */
+	search_result_type result;
+	volatile bool interrupt;	/* Set to stop the ponder search */
+	bool active;
+	pthread_t thread;
+} ponder_type;
+
+
+static void * ponder_thread( void * arg )
+{
+	ponder_type * ponder = (ponder_type *)arg;
+
+	search_root( ponder->searches, ponder->num_threads,
+		&ponder->players[ponder->mover_id], ponder->max_ply,
+		ponder->movetime, &ponder->result );
+	return( NULL );
+} /* ponder_thread() */
+
+
+/* Start pondering the reply to the move the computer has just made,
+ * whose search gave result
+ */
+
+static void ponder_start( ponder_type * ponder, search_type * searches,
+	unsigned int num_threads, const player_data_type * computer,
+	const search_result_type * result, unsigned int max_ply, double movetime )
+{
+	player_data_type * human;
+	move_type move;
+	uint64_t key = 0;
+
+	ponder->active = FALSE;
+
+	if( result->pv.length < 2 ) return;	/* No reply expected */
+
+	ponder->players[computer->id] = *computer;
+	ponder->players[computer->opponent->id] = *computer->opponent;
+	ponder->players[0].opponent = &ponder->players[1];
+	ponder->players[1].opponent = &ponder->players[0];
+	human = &ponder->players[computer->opponent->id];
+	move.sq = result->pv.move[1];
+	move.flips = compute_flips( move.sq, human->discs,
+		human->opponent->discs );
+
+	if( move.flips == 0 ) return;
+
+	apply_move( human, &move, &key );
+	ponder->searches = searches;
+	ponder->num_threads = num_threads;
+	ponder->max_ply = max_ply;
+	ponder->movetime = movetime;
+	ponder->mover_id = computer->id;
+	ponder->interrupt = FALSE;
+	searches[0].interrupt = &ponder->interrupt;
+
+	if( pthread_create( &ponder->thread, NULL, ponder_thread, ponder ) != 0 ) {
+		searches[0].interrupt = NULL;
+		return;
+	} /* if */
+
+	ponder->active = TRUE;
+} /* ponder_start() */
+
+
+/* Stop pondering, now that mover is to move (NULL if the position has
+ * gone some other way).  If it is the position pondered, let the search
+ * finish and return TRUE with its result; otherwise stop it and return
+ * FALSE.
+ */
+
+static bool ponder_finish( ponder_type * ponder,
+	const player_data_type * mover, search_result_type * result )
+{
+	bool hit;
+
+	if( !ponder->active ) return( FALSE );
+
+	hit = ( mover != NULL  &&  mover->id == ponder->mover_id
+		&&  mover->discs == ponder->players[mover->id].discs
+		&&  mover->opponent->discs
+			== ponder->players[mover->opponent->id].discs ) ? TRUE : FALSE;
+
+	if( !hit ) {
+		ponder->interrupt = TRUE;
+	} /* if */
+
+	pthread_join( ponder->thread, NULL );
+	ponder->active = FALSE;
+	ponder->searches[0].interrupt = NULL;
+
+	if( !hit ) return( FALSE );
+
+	*result = ponder->result;
+	return( TRUE );
+} /* ponder_finish() */
+
+
+/* Set the counts and weights of x_player and its opponent from their discs */
+
+static void count_discs( player_data_type * x_player )
+{
+	player_data_type * o_player = x_player->opponent;
+
+	x_player->count = bit_count( x_player->discs );
+	o_player->count = bit_count( o_player->discs );
+	x_player->weight = weight_of( x_player->discs );
+	o_player->weight = weight_of( o_player->discs );
+} /* count_discs() */
+
+
+/* Read a position: BOARD_AREA squares row by row, each 'X', 'O', or
+ * '-' or '.' for empty, then white space and the side to move.
+ * Sets up x_player and its opponent, and returns the player to move,
+ * or NULL if the line does not hold a position.
+ */
+
+static player_data_type * parse_position( const char * line,
+	player_data_type * x_player )
+{
+	player_data_type * o_player = x_player->opponent;
+	unsigned int sq;
+
+	x_player->discs = o_player->discs = 0;
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+
+		if( line[sq] == x_player->marker ) {
+			x_player->discs |= SQUARE_BIT(sq);
+		} else if( line[sq] == o_player->marker ) {
+			o_player->discs |= SQUARE_BIT(sq);
+		} else if( line[sq] != '-'  &&  line[sq] != '.' ) {
+			return( NULL );
+		} /* if */
+	} /* for */
+
+	count_discs( x_player );
+
+	for( line += BOARD_AREA; isspace( (unsigned char)*line ); line++ ) {
+	} /* for */
+
+	if( toupper( (unsigned char)*line ) == x_player->marker ) return( x_player );
+
+	if( toupper( (unsigned char)*line ) == o_player->marker ) return( o_player );
+
+	return( NULL );
+} /* parse_position() */
+
+
+/* Write a position in the form read by parse_position() into out,
+ * returning the number of characters written
+ */
+
+static int print_position( char * out, const player_data_type * x_player,
+	const player_data_type * player )
+{
+	bitboard_type bit;
+	unsigned int sq;
+
+	for( sq = 0; sq < BOARD_AREA; sq++ ) {
+		bit = SQUARE_BIT(sq);
+		out[sq] = ( x_player->discs & bit ) ? x_player->marker
+			: ( x_player->opponent->discs & bit ) ? x_player->opponent->marker
+			: '-';
+	} /* for */
+
+	return( BOARD_AREA + sprintf( out + BOARD_AREA, " %c", player->marker ) );
+} /* print_position() */
+
+
+/* Binary records (--binary), for batches too large to parse as text.
+ * A file is a record_header_type and then fixed-size records, in the
+ * byte order of the machine that wrote it: position records, read by
+ * --analyze --binary and made from text by --to-binary; or the result
+ * records that --analyze --binary writes, one per position in input order.
+ * --to-text turns either kind back into lines of text.
+ * A bitboard takes RECORD_WORDS words, the low squares in the first.
+ */
+
+#define POSITION_MAGIC	"OTHP"
+#define RESULT_MAGIC	"OTHR"
+#define RECORD_WORDS	((BOARD_AREA+63)/64)
+#define RECORD_PV_LENGTH	21	/* Moves of the chain kept in a result */
+#define RECORD_BUFFER_SIZE	(1 << 20)	/* Of the streams of records */
+
+typedef struct {
+	char magic[4];			/* POSITION_MAGIC or RESULT_MAGIC */
+	uint32_t board_size;		/* BOARD_SIZE */
+	uint32_t record_size;		/* sizeof the records that follow */
+	uint32_t reserved;
+} record_header_type;
+
+typedef struct {
+	uint64_t discs[2][RECORD_WORDS];	/* X's, then O's */
+	uint8_t to_move;		/* 0 for X, 1 for O */
+	uint8_t depth;			/* To search to; 0 for the default */
+	uint8_t reserved[6];
+} position_record_type;
+
+typedef struct {
+	position_record_type position;	/* As read */
+	uint64_t nodes;
+	uint32_t microseconds;
+	int16_t score;			/* Or the final disc differential */
+	uint8_t move;			/* NO_MOVE if the side to move has none */
+	uint8_t exact;			/* Solved to the end of the game */
+	uint8_t depth;
+	uint8_t partial;		/* Score and chain from depth + 1, unfinished */
+	uint8_t pv_length;
+	uint8_t pv[RECORD_PV_LENGTH];
+} result_record_type;
+
+
+/* Read and check the header of a file of records of the given kind */
+
+static bool read_record_header( FILE * in, const char * magic,
+	size_t record_size )
+{
+	record_header_type header;
+
+	return( fread( &header, sizeof( header ), 1, in ) == 1
+		&&  memcmp( header.magic, magic, 4 ) == 0
+		&&  header.board_size == BOARD_SIZE
+		&&  header.record_size == record_size );
+} /* read_record_header() */
+
+
+static void write_record_header( FILE * out, const char * magic,
+	size_t record_size )
+{
+	record_header_type header;
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, magic, 4 );
+	header.board_size = BOARD_SIZE;
+	header.record_size = (uint32_t)record_size;
+	fwrite( &header, sizeof( header ), 1, out );
+} /* write_record_header() */
+
+
+/* Set up x_player and its opponent from a record, and return the player
+ * to move, or NULL if the record does not hold a position
+ */
+
+static player_data_type * record_position( const position_record_type * record,
+	player_data_type * x_player )
+{
+	player_data_type * o_player = x_player->opponent;
+	unsigned int w;
+
+	x_player->discs = o_player->discs = 0;
+
+	for( w = 0; w < RECORD_WORDS; w++ ) {
+		x_player->discs |= (bitboard_type)record->discs[0][w] << ( 64 * w );
+		o_player->discs |= (bitboard_type)record->discs[1][w] << ( 64 * w );
+	} /* for */
+
+	if( ( x_player->discs & o_player->discs ) != 0
+		||  ( ( x_player->discs | o_player->discs ) & ~FULL_BOARD ) != 0
+		||  record->to_move > 1 ) {
+
+		return( NULL );
+	} /* if */
+
+	count_discs( x_player );
+	return( ( record->to_move == 0 ) ? x_player : o_player );
+} /* record_position() */
+
+
+static void make_record( position_record_type * record,
+	const player_data_type * x_player, const player_data_type * player,
+	unsigned int depth )
+{
+	unsigned int w;
+
+	memset( record, 0, sizeof( *record ) );
+
+	for( w = 0; w < RECORD_WORDS; w++ ) {
+		record->discs[0][w] = (uint64_t)( x_player->discs >> ( 64 * w ) );
+		record->discs[1][w] = (uint64_t)( x_player->opponent->discs
+			>> ( 64 * w ) );
+	} /* for */
+
+	record->to_move = ( player == x_player ) ? 0 : 1;
+	record->depth = (uint8_t)depth;
+} /* make_record() */
+
+
+/* Write the analysis of a position into out, as
+ *   move=r,c score=n exact=0|1 depth=d partial=0|1 nodes=n time=seconds
+ *   pv=r,c ...
+ * after a space, ending the line.  depth is that of the last iteration
+ * finished; with partial=1, the score and chain come from the unfinished
+ * one after it.  A side with no legal move (an empty chain) gets
+ * move=pass, and a finished game (also exact) move=none with its final
+ * disc differential as the score.
+ */
+
+static void print_analysis( char * out, const char * end,
+	const search_result_type * result, unsigned long nodes, double seconds )
+{
+	unsigned int i;
+
+	if( result->pv.length == 0 ) {
+
+		if( result->exact ) {
+			sprintf( out, " move=none score=%d exact=1 depth=0 partial=0"
+				" nodes=0 time=0\n", result->score );
+		} else {
+			sprintf( out, " move=pass score=0 exact=0 depth=0 partial=0"
+				" nodes=0 time=0\n" );
+		} /* if */
+
+		return;
+	} /* if */
+
+	out += sprintf( out, " move=%d,%d score=%d exact=%d depth=%d partial=%d"
+		" nodes=%lu time=%.3f pv=",
+		result->pv.move[0] / BOARD_SIZE, result->pv.move[0] % BOARD_SIZE,
+		result->score, result->exact ? 1 : 0, result->depth,
+		result->partial ? 1 : 0, nodes, seconds );
+
+	/* Each square takes at most 6 characters */
+	for( i = 0; i < result->pv.length  &&  end - out > 8; i++ ) {
+		out += sprintf( out, ( i > 0 ) ? " %d,%d" : "%d,%d",
+			result->pv.move[i] / BOARD_SIZE, result->pv.move[i] % BOARD_SIZE );
+	} /* for */
+
+	strcpy( out, "\n" );
+} /* print_analysis() */
+
+
+/* Search a position for batch analysis, to max_ply unless depth is
+ * nonzero, leaving the result, its nodes and its time.  A position
+ * without a legal move is not searched: see print_analysis().
+ */
+
+static void analyze_position( player_data_type * player,
+	unsigned long line_num, search_type * searches, unsigned int num_threads,
+	unsigned int max_ply, double movetime, search_result_type * result,
+	unsigned long * nodes, double * seconds )
+{
+	search_stats_type stats;
+	double start;
+
+	*nodes = 0;
+	*seconds = 0.0;
+
+	if( legal_moves( player->discs, player->opponent->discs ) == 0 ) {
+		result->pv.length = 0;
+		result->depth = 0;
+		result->partial = FALSE;
+		result->exact = ( legal_moves( player->opponent->discs,
+			player->discs ) == 0 ) ? TRUE : FALSE;
+		result->score = result->exact
+			? (int)player->count - (int)player->opponent->count : 0;
+		return;
+	} /* if */
+
+	/* Tie-breaking depends only on the input, not on who ran it when */
+	searches[0].rand_state = line_num;
+	start = now_seconds();
+	search_root( searches, num_threads, player, max_ply, movetime, result );
+	sum_stats( searches, num_threads, &stats );
+	*nodes = stats.node_count;
+	*seconds = now_seconds() - start;
+} /* analyze_position() */
+
+
+/* Analyze one line of batch input on the given search records, leaving
+ * the line to print in output:  the position, then its analysis (see
+ * print_analysis()).
+ * Returns FALSE, with a message in output for stderr if it is not blank
+ * or a comment, when the line holds no position.
+ */
+
+static bool analyze_line( const char * line, unsigned long line_num,
+	search_type * searches, unsigned int num_threads,
+	unsigned int max_ply, double movetime, char output[BATCH_OUTPUT_SIZE] )
+{
+	player_data_type x_data, o_data, * player;
+	search_result_type result;
+	unsigned long nodes;
+	double seconds;
+	char * out = output;
+
+	output[0] = '\0';
+
+	if( line[0] == '#'  ||  line[strspn( line, " \t\r\n" )] == '\0' ) {
+		return( FALSE );
+	} /* if */
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+	player = ( strlen( line ) > BOARD_AREA )
+		? parse_position( line, &x_data ) : NULL;
+
+	if( player == NULL ) {
+		sprintf( output, "Line %lu: not a position\n", line_num );
+		return( FALSE );
+	} /* if */
+
+	out += print_position( out, &x_data, player );
+	analyze_position( player, line_num, searches, num_threads, max_ply,
+		movetime, &result, &nodes, &seconds );
+	print_analysis( out, output + BATCH_OUTPUT_SIZE, &result, nodes, seconds );
+	return( TRUE );
+} /* analyze_line() */
+
+
+/* Analyze a position record, filling in its result record.  Returns
+ * FALSE, with a message in output for stderr, if it holds no position.
+ */
+
+static bool analyze_record( const position_record_type * record,
+	unsigned long record_num, search_type * searches,
+	unsigned int num_threads, unsigned int max_ply, double movetime,
+	result_record_type * result_record, char output[BATCH_OUTPUT_SIZE] )
+{
+	player_data_type x_data, o_data, * player;
+	search_result_type result;
+	unsigned long nodes;
+	double seconds;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+	player = record_position( record, &x_data );
+
+	if( player == NULL ) {
+		sprintf( output, "Record %lu: not a position\n", record_num );
+		return( FALSE );
+	} /* if */
+
+	if( record->depth > 0 ) {
+		max_ply = ( record->depth < MAX_PLY ) ? record->depth : MAX_PLY;
+	} /* if */
+
+	analyze_position( player, record_num, searches, num_threads, max_ply,
+		movetime, &result, &nodes, &seconds );
+	memset( result_record, 0, sizeof( *result_record ) );
+	result_record->position = *record;
+	result_record->nodes = nodes;
+	result_record->microseconds = (uint32_t)( seconds * 1e6 );
+	result_record->score = (int16_t)result.score;
+	result_record->move = ( result.pv.length > 0 ) ? result.pv.move[0]
+		: NO_MOVE;
+	result_record->exact = result.exact ? 1 : 0;
+	result_record->depth = (uint8_t)result.depth;
+	result_record->partial = result.partial ? 1 : 0;
+	result_record->pv_length = ( result.pv.length < RECORD_PV_LENGTH )
+		? (uint8_t)result.pv.length : RECORD_PV_LENGTH;
+	memcpy( result_record->pv, result.pv.move, result_record->pv_length );
+	return( TRUE );
+} /* analyze_record() */
+
+
+/* Batch analysis with a pool of workers.  The main thread reads lines
+ * (or records) into a ring of jobs and writes the results out in input
+ * order as they are finished; each worker takes the oldest job not yet
+ * taken and searches it on its own search record.  Every job takes a whole
+ * search, so a shared queue under one mutex balances the load as well as
+ * per-worker queues would.
+ */
+
+typedef struct {
+	char line[256];
+	position_record_type record;	/* Instead of the line, for --binary */
+	unsigned long line_num;
+	char output[BATCH_OUTPUT_SIZE];	/* The line, or a message for stderr */
+	result_record_type result;	/* For --binary */
+	bool is_position, done;
+} batch_job_type;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t job_ready, job_done;
+	batch_job_type * jobs;		/* A ring of num_jobs jobs */
+	unsigned long num_jobs, next_read, next_claim, next_write;
+	bool eof, binary;
+	unsigned int max_ply;
+	double movetime;
+} batch_type;
+
+typedef struct {
+	batch_type * batch;
+	search_type * search;
+	tt_type tt;			/* As large as the shared table */
+	pthread_t thread;
+} batch_worker_type;
+
+
+/* Read the input of the next job; returns FALSE at the end */
+
+static bool read_job( FILE * in, bool binary, batch_job_type * job )
+{
+	if( binary ) {
+		return( fread( &job->record, sizeof( job->record ), 1, in ) == 1 );
+	} /* if */
+
+	return( fgets( job->line, sizeof( job->line ), in ) != NULL );
+} /* read_job() */
+
+
+/* Each job is searched as if from an empty table (see analyze_positions())
+ * and history, so that its result does not depend on the jobs before it
+ * or on which worker ran it
+ */
+
+static void run_job( batch_job_type * job, bool binary,
+	search_type * searches, unsigned int num_threads, unsigned int max_ply,
+	double movetime )
+{
+	memset( searches[0].history, 0, sizeof( searches[0].history ) );
+
+	if( binary ) {
+		job->output[0] = '\0';
+		job->is_position = analyze_record( &job->record, job->line_num,
+			searches, num_threads, max_ply, movetime, &job->result,
+			job->output );
+	} else {
+		job->is_position = analyze_line( job->line, job->line_num,
+			searches, num_threads, max_ply, movetime, job->output );
+	} /* if */
+} /* run_job() */
+
+
+static void write_job( const batch_job_type * job, bool binary )
+{
+	if( binary  &&  job->is_position ) {
+		fwrite( &job->result, sizeof( job->result ), 1, stdout );
+	} else {
+		fputs( job->output, job->is_position ? stdout : stderr );
+	} /* if */
+} /* write_job() */
+
+
+static void * batch_worker( void * arg )
+{
+	batch_worker_type * worker = (batch_worker_type *)arg;
+	batch_type * batch = worker->batch;
+	batch_job_type * job;
+
+	pthread_mutex_lock( &batch->lock );
+
+	for( ; ; ) {
+
+		while( batch->next_claim == batch->next_read  &&  !batch->eof ) {
+			pthread_cond_wait( &batch->job_ready, &batch->lock );
+		} /* while */
+
+		if( batch->next_claim == batch->next_read ) break;	/* All done */
+
+		job = &batch->jobs[batch->next_claim++ % batch->num_jobs];
+		pthread_mutex_unlock( &batch->lock );
+
+		run_job( job, batch->binary, worker->search, 1, batch->max_ply,
+			batch->movetime );
+
+		pthread_mutex_lock( &batch->lock );
+		job->done = TRUE;
+		pthread_cond_signal( &batch->job_done );
+	} /* for */
+
+	pthread_mutex_unlock( &batch->lock );
+	return( NULL );
+} /* batch_worker() */
+
+
+/* Analyze every position read from in, printing one line for each, or
+ * with binary, writing a result record for each position record.  The
+ * records go through buffers of RECORD_BUFFER_SIZE.  Returns FALSE if
+ * in does not start with the header of a file of position records.
+ * Each worker has a table of its own, isolated so that each search sees
+ * only its own entries, as if the table had been cleared for it.
+ */
+
+static bool analyze_positions( FILE * in, bool binary, search_type * searches,
+	unsigned int num_threads, unsigned int max_ply, double movetime )
+{
+	static batch_job_type single_job;
+	unsigned long line_num = 0;
+	unsigned int t;
+	batch_type batch;
+	batch_worker_type workers[MAX_THREADS];
+	batch_job_type * job;
+
+	if( binary ) {
+		setvbuf( in, NULL, _IOFBF, RECORD_BUFFER_SIZE );
+		setvbuf( stdout, NULL, _IOFBF, RECORD_BUFFER_SIZE );
+
+		if( !read_record_header( in, POSITION_MAGIC,
+			sizeof( position_record_type ) ) ) {
+
+			return( FALSE );
+		} /* if */
+
+		write_record_header( stdout, RESULT_MAGIC,
+			sizeof( result_record_type ) );
+	} /* if */
+
+	if( num_threads == 1 ) {
+		job = &single_job;
+		searches[0].tt->isolated = TRUE;
+
+		while( read_job( in, binary, job ) ) {
+			job->line_num = ++line_num;
+			run_job( job, binary, searches, 1, max_ply, movetime );
+			write_job( job, binary );
+		} /* while */
+
+		searches[0].tt->isolated = FALSE;
+		fflush( stdout );
+		return( TRUE );
+	} /* if */
+
+	batch.num_jobs = BATCH_JOBS * num_threads;
+	batch.jobs = (batch_job_type *)malloc( batch.num_jobs
+		* sizeof( batch_job_type ) );
+
+	if( batch.jobs == NULL ) {
+		fprintf( stderr, "Cannot allocate the batch jobs\n" );
+		exit( 1 );
+	} /* if */
+
+	batch.next_read = batch.next_claim = batch.next_write = 0;
+	batch.eof = FALSE;
+	batch.binary = binary;
+	batch.max_ply = max_ply;
+	batch.movetime = movetime;
+	pthread_mutex_init( &batch.lock, NULL );
+	pthread_cond_init( &batch.job_ready, NULL );
+	pthread_cond_init( &batch.job_done, NULL );
+
+	for( t = 0; t < num_threads; t++ ) {
+		workers[t].batch = &batch;
+		workers[t].search = &searches[t];
+		tt_init( &workers[t].tt, searches[0].tt->size );
+		workers[t].tt.isolated = TRUE;
+		searches[t].tt = &workers[t].tt;
+
+		if( pthread_create( &workers[t].thread, NULL, batch_worker,
+			&workers[t] ) != 0 ) {
+
+			fprintf( stderr, "Cannot start batch worker %d\n", t );
+			exit( 1 );
+		} /* if */
+	} /* for */
+
+	pthread_mutex_lock( &batch.lock );
+
+	while( !batch.eof  ||  batch.next_write < batch.next_read ) {
+
+		if( !batch.eof  &&  batch.next_read - batch.next_write < batch.num_jobs ) {
+			/* Read ahead while there is room in the ring */
+			pthread_mutex_unlock( &batch.lock );
+			job = &batch.jobs[batch.next_read % batch.num_jobs];
+
+			if( read_job( in, binary, job ) ) {
+				job->line_num = ++line_num;
+				job->done = FALSE;
+				pthread_mutex_lock( &batch.lock );
+				batch.next_read++;
+				pthread_cond_signal( &batch.job_ready );
+			} else {
+				pthread_mutex_lock( &batch.lock );
+				batch.eof = TRUE;
+				pthread_cond_broadcast( &batch.job_ready );
+			} /* if */
+
+			continue;
+		} /* if */
+
+		job = &batch.jobs[batch.next_write % batch.num_jobs];
+
+		while( !job->done ) {
+			pthread_cond_wait( &batch.job_done, &batch.lock );
+		} /* while */
+
+		pthread_mutex_unlock( &batch.lock );
+		write_job( job, binary );
+		pthread_mutex_lock( &batch.lock );
+		batch.next_write++;
+	} /* while */
+
+	pthread_mutex_unlock( &batch.lock );
+
+	for( t = 0; t < num_threads; t++ ) {
+		pthread_join( workers[t].thread, NULL );
+		tt_free( &workers[t].tt );
+		searches[t].tt = &shared_tt;
+	} /* for */
+
+	pthread_cond_destroy( &batch.job_ready );
+	pthread_cond_destroy( &batch.job_done );
+	pthread_mutex_destroy( &batch.lock );
+	free( batch.jobs );
+	fflush( stdout );
+	return( TRUE );
+} /* analyze_positions() */
+
+
+/* --to-binary: write a position record for each position read from in,
+ * one per line as for --analyze, optionally followed by depth=n
+ */
+
+static void positions_to_records( FILE * in )
+{
+	player_data_type x_data, o_data, * player;
+	position_record_type record;
+	char line[256], * depth;
+	unsigned long line_num = 0;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+	setvbuf( stdout, NULL, _IOFBF, RECORD_BUFFER_SIZE );
+	write_record_header( stdout, POSITION_MAGIC, sizeof( record ) );
+
+	while( fgets( line, sizeof( line ), in ) != NULL ) {
+		line_num++;
+
+		if( line[0] == '#'  ||  line[strspn( line, " \t\r\n" )] == '\0' ) {
+			continue;
+		} /* if */
+
+		player = ( strlen( line ) > BOARD_AREA )
+			? parse_position( line, &x_data ) : NULL;
+
+		if( player == NULL ) {
+			fprintf( stderr, "Line %lu: not a position\n", line_num );
+			continue;
+		} /* if */
+
+		depth = strstr( line + BOARD_AREA, "depth=" );
+		make_record( &record, &x_data, player,
+			( depth != NULL ) ? atoi( depth + 6 ) : 0 );
+		fwrite( &record, sizeof( record ), 1, stdout );
+	} /* while */
+
+	fflush( stdout );
+} /* positions_to_records() */
+
+
+/* --to-text: print the records read from in as lines of text, the
+ * positions as --analyze reads them and the results as it prints them;
+ * with draw, each position is also drawn by draw_board().  Returns FALSE
+ * if in does not start with the header of a file of records.
+ */
+
+static bool records_to_text( FILE * in, bool draw )
+{
+	player_data_type x_data, o_data, * player;
+	record_header_type header;
+	result_record_type record;
+	search_result_type result;
+	char output[BATCH_OUTPUT_SIZE];
+	size_t size;
+	unsigned long record_num = 0;
+	bool results;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+	setvbuf( in, NULL, _IOFBF, RECORD_BUFFER_SIZE );
+
+	if( fread( &header, sizeof( header ), 1, in ) != 1
+		||  header.board_size != BOARD_SIZE ) {
+
+		return( FALSE );
+	} /* if */
+
+	results = ( memcmp( header.magic, RESULT_MAGIC, 4 ) == 0 ) ? TRUE : FALSE;
+	size = results ? sizeof( result_record_type )
+		: sizeof( position_record_type );
+
+	if( ( !results  &&  memcmp( header.magic, POSITION_MAGIC, 4 ) != 0 )
+		||  header.record_size != size ) {
+
+		return( FALSE );
+	} /* if */
+
+	/* A position record is the start of a result record */
+	while( fread( &record, size, 1, in ) == 1 ) {
+		player = record_position( &record.position, &x_data );
+		record_num++;
+
+		if( player == NULL ) {
+			fprintf( stderr, "Record %lu: not a position\n", record_num );
+			continue;
+		} /* if */
+
+		if( draw ) {
+			draw_board( &x_data );
+		} /* if */
+
+		print_position( output, &x_data, player );
+
+		if( results ) {
+			result.score = record.score;
+			result.exact = record.exact ? TRUE : FALSE;
+			result.depth = record.depth;
+			result.partial = record.partial ? TRUE : FALSE;
+			result.pv.length = record.pv_length;
+			memcpy( result.pv.move, record.pv, record.pv_length );
+			print_analysis( output + BOARD_AREA + 2, output + BATCH_OUTPUT_SIZE,
+				&result, (unsigned long)record.nodes,
+				record.microseconds / 1e6 );
+		} else if( record.position.depth > 0 ) {
+			sprintf( output + BOARD_AREA + 2, " depth=%d\n",
+				record.position.depth );
+		} else {
+			strcpy( output + BOARD_AREA + 2, "\n" );
+		} /* if */
+
+		fputs( output, stdout );
+	} /* while */
+
+	return( TRUE );
+} /* records_to_text() */
+
+
+/* Fit ProbCut pairs to the positions read from in, one per line as for
+ * --analyze, and print them in the form load_probcut() reads.  Each
+ * position is searched full-width to every depth up to max_ply; depth d
+ * is paired with a shallow depth of about d/2, of the same parity, since
+ * the side to move at the leaves biases the score.
+ */
+
+static void fit_probcut( FILE * in, search_type * search, unsigned int max_ply )
+{
+	player_data_type x_data, o_data, * player, * root;
+	char line[256];
+	int value[MAX_PLY + 1];
+	double sum_s[MAX_PLY + 1], sum_d[MAX_PLY + 1], sum_ss[MAX_PLY + 1],
+		sum_sd[MAX_PLY + 1], sum_dd[MAX_PLY + 1], n = 0.0, a, b, var,
+		residual;
+	unsigned int shallow[MAX_PLY + 1], d;
+	bool saved = probcut;
+
+	probcut = FALSE;
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	for( d = 0; d <= max_ply; d++ ) {
+		shallow[d] = ( ( d - d / 2 ) % 2 == 0 ) ? d / 2 : d / 2 - 1;
+		sum_s[d] = sum_d[d] = sum_ss[d] = sum_sd[d] = sum_dd[d] = 0.0;
+	} /* for */
+
+	search->stop_requested = FALSE;
+	search->stop = &search->stop_requested;
+	search->deadline = 0.0;
+
+	while( fgets( line, sizeof( line ), in ) != NULL ) {
+
+		if( line[0] == '#'  ||  strlen( line ) <= BOARD_AREA ) continue;
+
+		player = parse_position( line, &x_data );
+
+		/* Searches that reach the end of the game would not fit the line */
+		if( player == NULL  ||  BOARD_AREA - player->count
+			- player->opponent->count <= max_ply ) continue;
+
+		start_search( search, player, max_ply );
+		tt_clear( search->tt );
+		root = &search->players[search->root_id];
+
+		for( d = 1; d <= max_ply; d++ ) {
+			value[d] = best_move( search, root, 1, d, INIT_MAX_EFFECT,
+				-INIT_MAX_EFFECT );
+		} /* for */
+
+		for( d = 3; d <= max_ply; d++ ) {
+			sum_s[d] += value[shallow[d]];
+			sum_d[d] += value[d];
+			sum_ss[d] += (double)value[shallow[d]] * value[shallow[d]];
+			sum_sd[d] += (double)value[shallow[d]] * value[d];
+			sum_dd[d] += (double)value[d] * value[d];
+		} /* for */
+
+		n += 1.0;
+	} /* while */
+
+	printf( "# depth shallow a b sigma t, fitted to %.0f positions\n", n );
+
+	for( d = 3; d <= max_ply  &&  n > 1.0; d++ ) {
+		var = sum_ss[d] - sum_s[d] * sum_s[d] / n;
+
+		if( var <= 0.0 ) continue;
+
+		a = ( sum_sd[d] - sum_s[d] * sum_d[d] / n ) / var;
+
+		if( a <= 0.0 ) continue;
+
+		b = ( sum_d[d] - a * sum_s[d] ) / n;
+		residual = ( sum_dd[d] - 2.0 * a * sum_sd[d] - 2.0 * b * sum_d[d]
+			+ a * a * sum_ss[d] + 2.0 * a * b * sum_s[d] + n * b * b ) / n;
+		printf( "%u %u %.4f %.4f %.4f %.2f\n", d, shallow[d], a, b,
+			sqrt( ( residual > 0.0 ) ? residual : 0.0 ), PROBCUT_T );
+	} /* for */
+
+	probcut = saved;
+} /* fit_probcut() */
+
+
+/* Opening book ("--book file")
+ * The book is a file holding a book_header_type and then book_entry_type
+ * records sorted by key, mapped into memory and searched by bisection.
+ * A position and its seven rotations and reflections are one entry: the
+ * key is that of whichever of the eight has the smallest Zobrist hash,
+ * with the side to move's markers hashed as player 0's, and the move is
+ * stored for that orientation.  A position may have several entries, one
+ * for each move, chosen between in proportion to their weights.
+ * "othello --build-book file" writes a book from batch analysis output
+ * read from the standard input; each analyzed position gives its best
+ * move one more unit of weight, with the score of the deepest analysis.
+ */
+
+#define BOOK_MAGIC	"OTHB"
+#define NUM_SYMMETRIES	8
+
+typedef struct {
+	char magic[4];			/* BOOK_MAGIC */
+	uint32_t board_size;		/* BOARD_SIZE */
+	uint64_t zobrist_check;		/* zobrist_key[0][0], so keys match */
+	uint64_t num_entries;
+} book_header_type;
+
+typedef struct {
+	uint64_t key;
+	int16_t score;
+	uint16_t weight;
+	uint8_t move;			/* The square, in the stored orientation */
+	uint8_t depth;			/* Of the deepest analysis of the move */
+	uint8_t unused[2];
+} book_entry_type;
+
+const book_entry_type * book = NULL;
+uint64_t book_size;			/* The number of entries */
+unsigned int sym_square[NUM_SYMMETRIES][BOARD_AREA];	/* Where sq goes */
+unsigned int sym_inverse[NUM_SYMMETRIES][BOARD_AREA];
+
+
+/* Set up the symmetry tables:  symmetry s transposes the board if bit 2
+ * is set, then reflects the columns if bit 0 is set and the rows if bit 1
+ */
+
+static void init_symmetries( void )
+{
+	unsigned int s, sq, r, c, t;
+
+	for( s = 0; s < NUM_SYMMETRIES; s++ ) {
+
+		for( sq = 0; sq < BOARD_AREA; sq++ ) {
+			r = sq / BOARD_SIZE;
+			c = sq % BOARD_SIZE;
+
+			if( s & 4 ) {
+				t = r;
+				r = c;
+				c = t;
+			} /* if */
+
+			if( s & 1 ) c = BOARD_SIZE - 1 - c;
+
+			if( s & 2 ) r = BOARD_SIZE - 1 - r;
+
+			sym_square[s][sq] = SQUARE(r,c);
+			sym_inverse[s][SQUARE(r,c)] = sq;
+		} /* for */
+	} /* for */
+} /* init_symmetries() */
+
+
+static bitboard_type transform( bitboard_type b, unsigned int s )
+{
+	bitboard_type result = 0;
+
+	for( ; b != 0; b &= b - 1 ) {
+		result |= SQUARE_BIT( sym_square[s][first_bit( b )] );
+	} /* for */
+
+	return( result );
+} /* transform() */
+
+
+/* The book key of a position, and the symmetry that gives it */
+
+static uint64_t book_key( bitboard_type mine, bitboard_type theirs,
+	unsigned int * symP )
+{
+	bitboard_type b;
+	uint64_t key, best_key = 0;
+	unsigned int s;
+
+	for( s = 0; s < NUM_SYMMETRIES; s++ ) {
+		key = 0;
+
+		for( b = transform( mine, s ); b != 0; b &= b - 1 ) {
+			key ^= zobrist_key[0][first_bit( b )];
+		} /* for */
+
+		for( b = transform( theirs, s ); b != 0; b &= b - 1 ) {
+			key ^= zobrist_key[1][first_bit( b )];
+		} /* for */
+
+		if( s == 0  ||  key < best_key ) {
+			best_key = key;
+			*symP = s;
+		} /* if */
+	} /* for */
+
+	return( best_key );
+} /* book_key() */
+
+
+/* Map the book.  Returns FALSE if the file cannot be used. */
+
+static bool book_open( const char * file_name )
+{
+	const book_header_type * header;
+	struct stat st;
+	void * map;
+	int fd = open( file_name, O_RDONLY );
+
+	if( fd < 0 ) return( FALSE );
+
+	if( fstat( fd, &st ) != 0  ||  (size_t)st.st_size < sizeof( *header ) ) {
+		close( fd );
+		return( FALSE );
+	} /* if */
+
+	map = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if( map == MAP_FAILED ) return( FALSE );
+
+	header = (const book_header_type *)map;
+
+	if( memcmp( header->magic, BOOK_MAGIC, 4 ) != 0
+		||  header->board_size != BOARD_SIZE
+		||  header->zobrist_check != zobrist_key[0][0]
+		||  (size_t)st.st_size != sizeof( *header )
+			+ header->num_entries * sizeof( book_entry_type ) ) {
+
+		munmap( map, st.st_size );
+		return( FALSE );
+	} /* if */
+
+	/* Left mapped until the program exits */
+	book = (const book_entry_type *)( header + 1 );
+	book_size = header->num_entries;
+	return( TRUE );
+} /* book_open() */
+
+
+/* Look the player's position up in the book.  If it is there, choose one
+ * of its moves, using choice (a random number) to weigh them, and return
+ * TRUE with the square and score.
+ */
+
+static bool book_probe( const player_data_type * player, unsigned long choice,
+	unsigned int * sqP, int * scoreP )
+{
+	uint64_t key, low = 0, high = book_size, i, total = 0;
+	unsigned int s, sq;
+
+	if( book == NULL ) return( FALSE );
+
+	key = book_key( player->discs, player->opponent->discs, &s );
+
+	/* Find the first entry with the key */
+	while( low < high ) {
+		i = low + ( high - low ) / 2;
+
+		if( book[i].key < key ) {
+			low = i + 1;
+		} else {
+			high = i;
+		} /* if */
+	} /* while */
+
+	for( i = low; i < book_size  &&  book[i].key == key; i++ ) {
+		total += book[i].weight;
+	} /* for */
+
+	if( total == 0 ) return( FALSE );
+
+	for( choice %= total, i = low; choice >= book[i].weight; i++ ) {
+		choice -= book[i].weight;
+	} /* for */
+
+	/* Guard against a key shared by another position */
+	sq = sym_inverse[s][book[i].move];
+
+	if( ( ( player->discs | player->opponent->discs ) & SQUARE_BIT(sq) ) != 0
+		||  compute_flips( sq, player->discs, player->opponent->discs ) == 0 ) {
+
+		return( FALSE );
+	} /* if */
+
+	*sqP = sq;
+	*scoreP = book[i].score;
+	return( TRUE );
+} /* book_probe() */
+
+
+static int compare_book_entries( const void * a, const void * b )
+{
+	const book_entry_type * x = (const book_entry_type *)a,
+		* y = (const book_entry_type *)b;
+
+	if( x->key != y->key ) return( ( x->key < y->key ) ? -1 : 1 );
+
+	return( (int)x->move - (int)y->move );
+} /* compare_book_entries() */
+
+
+/* Build a book from lines of batch analysis output read from in */
+
+static bool build_book( FILE * in, const char * file_name )
+{
+	char line[BATCH_OUTPUT_SIZE], * field;
+	player_data_type x_data, o_data, * player;
+	book_header_type header;
+	book_entry_type * entries = NULL, * grown;
+	uint64_t num_entries = 0, max_entries = 0, i, n;
+	unsigned int row, col, depth, s;
+	int score;
+	FILE * out;
+	bool ok;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	while( fgets( line, sizeof( line ), in ) != NULL ) {
+		player = ( strlen( line ) > BOARD_AREA )
+			? parse_position( line, &x_data ) : NULL;
+
+		if( player == NULL  ||  ( field = strstr( line, " move=" ) ) == NULL
+			||  sscanf( field, " move=%u,%u score=%d exact=%*d depth=%u",
+				&row, &col, &score, &depth ) != 4
+			||  row >= BOARD_SIZE  ||  col >= BOARD_SIZE ) {
+
+			continue;	/* Passes, finished games and anything else */
+		} /* if */
+
+		if( num_entries == max_entries ) {
+			max_entries = ( max_entries > 0 ) ? 2 * max_entries : 1024;
+			grown = (book_entry_type *)realloc( entries,
+				max_entries * sizeof( book_entry_type ) );
+
+			if( grown == NULL ) {
+				free( entries );
+				return( FALSE );
+			} /* if */
+
+			entries = grown;
+		} /* if */
+
+		memset( &entries[num_entries], 0, sizeof( book_entry_type ) );
+		entries[num_entries].key = book_key( player->discs,
+			player->opponent->discs, &s );
+		entries[num_entries].move = (uint8_t)sym_square[s][SQUARE(row,col)];
+		entries[num_entries].score = (int16_t)score;
+		entries[num_entries].depth = (uint8_t)depth;
+		entries[num_entries].weight = 1;
+		num_entries++;
+	} /* while */
+
+	/* Merge the entries for the same move of the same position */
+	qsort( entries, num_entries, sizeof( book_entry_type ),
+		compare_book_entries );
+
+	for( i = n = 0; i < num_entries; i++ ) {
+
+		if( n > 0  &&  entries[n - 1].key == entries[i].key
+			&&  entries[n - 1].move == entries[i].move ) {
+
+			if( entries[n - 1].weight < UINT16_MAX ) {
+				entries[n - 1].weight++;
+			} /* if */
+
+			if( entries[i].depth > entries[n - 1].depth ) {
+				entries[n - 1].depth = entries[i].depth;
+				entries[n - 1].score = entries[i].score;
+			} /* if */
+		} else {
+			entries[n++] = entries[i];
+		} /* if */
+	} /* for */
+
+	memcpy( header.magic, BOOK_MAGIC, 4 );
+	header.board_size = BOARD_SIZE;
+	header.zobrist_check = zobrist_key[0][0];
+	header.num_entries = n;
+	out = fopen( file_name, "wb" );
+	ok = out != NULL  &&  fwrite( &header, sizeof( header ), 1, out ) == 1
+		&&  fwrite( entries, sizeof( book_entry_type ), n, out ) == n;
+
+	if( out != NULL  &&  fclose( out ) != 0 ) {
+		ok = FALSE;
+	} /* if */
+
+	if( ok ) {
+		fprintf( stderr, "%lu positions' moves written to %s\n",
+			(unsigned long)n, file_name );
+	} /* if */
+
+	free( entries );
+	return( ok );
+} /* build_book() */
+
+
+/* Place the four starting markers; X moves first */
+
+static void start_position( player_data_type * x_player )
+{
+	unsigned int mid = BOARD_SIZE / 2;
+
+	x_player->discs = SQUARE_BIT( SQUARE(mid-1,mid-1) )
+		| SQUARE_BIT( SQUARE(mid,mid) );
+	x_player->opponent->discs = SQUARE_BIT( SQUARE(mid-1,mid) )
+		| SQUARE_BIT( SQUARE(mid,mid-1) );
+	x_player->count = x_player->opponent->count = 2;
+	x_player->weight = weight_of( x_player->discs );
+	x_player->opponent->weight = weight_of( x_player->opponent->discs );
+} /* start_position() */
+
+
+/* Count the positions depth moves ahead of this one, making and undoing
+ * every legal move.  A pass counts as a move, and a finished game as a
+ * leaf however deep it is.
+ */
+
+static unsigned long long perft( player_data_type * player,
+	unsigned int depth )
+{
+	move_type move_list[MAX_NUM_MOVES];
+	unsigned int num_moves, i;
+	unsigned long long leaves = 0;
+	uint64_t key = 0;	/* Not used, but apply_move() keeps it */
+
+	if( depth == 0 ) return( 1 );
+
+	num_moves = generate_moves( player, move_list );
+
+	if( num_moves == 0 ) {
+
+		if( legal_moves( player->opponent->discs, player->discs ) == 0 ) {
+			return( 1 );
+		} /* if */
+
+		return( perft( player->opponent, depth - 1 ) );
+	} /* if */
+
+	if( depth == 1 ) return( num_moves );
+
+	for( i = 0; i < num_moves; i++ ) {
+		apply_move( player, &move_list[i], &key );
+		leaves += perft( player->opponent, depth - 1 );
+		undo_move( player, &move_list[i] );
+	} /* for */
+
+	return( leaves );
+} /* perft() */
+
+
+/* Print the perft counts to depths 1 through max_depth */
+
+static void run_perft( player_data_type * player, unsigned int max_depth )
+{
+	unsigned long long leaves;
+	unsigned int depth;
+	double start, elapsed;
+
+	for( depth = 1; depth <= max_depth; depth++ ) {
+		start = now_seconds();
+		leaves = perft( player, depth );
+		elapsed = now_seconds() - start;
+		printf( "perft %2u: %llu leaves in %.3f seconds (%.0f leaves/second)\n",
+			depth, leaves, elapsed, ( elapsed > 0.0 ) ? leaves / elapsed : 0.0 );
+	} /* for */
+} /* run_perft() */
+
+
+/* Search each position of the benchmark suite to a fixed depth, with tie
+ * breaking seeded by BENCH_SEED, and report the nodes and the time taken.
+ * With one thread the node counts are the same from run to run, so a
+ * change in them means the search itself has changed.
+ */
+
+#if BOARD_SIZE == 8
+static const char * const bench_positions[] = {
+	"-----------X--------X------XXX-----OXO----O-O----O---O---------- X",
+	"--O--------OO-------OO-----XOO----XXXO----O-X----O--XXX--------- X",
+	"--O--------OO-----O-OO-----OOO----XXOO----XOX----XOXXXX-XO------ X",
+	"O-O-X----O-XX-----O-XO-----OXO----XXOOX---XOOO---XOOOOOOXO------ X",
+	"O-O-X----O-XX-X---OXXX----OOOO---OOOOOO--XOOOO-O-XOOOOOOXO------ X",
+	"O-O-X----OOXX-X--XOOXX----OXOO--OOXXOOO-OOOXOO-OXXOXOOOOXO-X---- X",
+	"O-O-X---OOOOOOX--OXOXO---XOXOOOXOXXOOOX-OXOXOX-OXXOXXXOOXO-X-X-- X",
+	"OXO-X---OXOOOOX--XXOXO---XOXOOOXOXXOOOX-OXOXOX-OXOOOXXOOXOOX-X-- X"
+};
+
+#define NUM_BENCH_POSITIONS \
+	( sizeof( bench_positions ) / sizeof( bench_positions[0] ) )
+#else
+#define NUM_BENCH_POSITIONS	8
+#endif
+
+
+/* Set up position i of the suite, returning the player to move.  Other
+ * sizes of board than 8 have no fixed suite; the positions are reached
+ * by random moves from the start, spread over the game.
+ */
+
+static player_data_type * bench_position( unsigned int i,
+	player_data_type * x_player )
+{
+#if BOARD_SIZE == 8
+	return( parse_position( bench_positions[i], x_player ) );
+#else
+	player_data_type * player = x_player;
+	move_type move_list[MAX_NUM_MOVES];
+	unsigned long rand_state = BENCH_SEED + i;
+	unsigned int num_moves, ply, passes = 0;
+	uint64_t key = 0;
+
+	start_position( x_player );
+
+	for( ply = 0; ply < ( i + 1 ) * MAX_PLY / ( NUM_BENCH_POSITIONS + 2 )
+		&&  passes < 2; ply++ ) {
+
+		num_moves = generate_moves( player, move_list );
+
+		if( num_moves > 0 ) {
+			rand_state = rand_state * 1103515245UL + 12345;
+			apply_move( player, &move_list[( rand_state >> 16 ) % num_moves],
+				&key );
+			passes = 0;
+		} else {
+			passes++;
+		} /* if */
+
+		player = player->opponent;
+	} /* for */
+
+	return( player );
+#endif
+} /* bench_position() */
+
+/* Time each move generation kernel on the positions of the suite, with
+ * both sides to move, and check that they all agree
+ */
+
+static void run_kernel_bench( void )
+{
+	player_data_type x_data, o_data;
+	bitboard_type discs[NUM_BENCH_POSITIONS][2], moves, mine, theirs, sum,
+		scalar_sum = 0;
+	unsigned long calls;
+	unsigned int i, k, side, rep;
+	kernel_type kernel, saved = flip_kernel;
+	double start, elapsed;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	for( i = 0; i < NUM_BENCH_POSITIONS; i++ ) {
+		bench_position( i, &x_data );
+		discs[i][0] = x_data.discs;
+		discs[i][1] = o_data.discs;
+	} /* for */
+
+	for( kernel = KERNEL_SCALAR; kernel <= KERNEL_NEON; kernel++ ) {
+
+		if( !select_kernel( kernel ) ) continue;
+
+		sum = 0;
+		calls = 0;
+		start = now_seconds();
+
+		for( rep = 0; rep < BENCH_KERNEL_REPS; rep++ ) {
+
+			for( i = 0; i < NUM_BENCH_POSITIONS; i++ ) {
+
+				for( side = 0; side < 2; side++ ) {
+					mine = discs[i][side];
+					theirs = discs[i][1 - side];
+					moves = legal_moves( mine, theirs );
+					sum += moves;
+					calls++;
+
+					for( ; moves != 0; moves &= moves - 1 ) {
+						k = first_bit( moves );
+						sum += compute_flips( k, mine, theirs ) * (k + 1);
+						calls++;
+					} /* for */
+				} /* for */
+			} /* for */
+		} /* for */
+
+		elapsed = now_seconds() - start;
+
+		if( kernel == KERNEL_SCALAR ) {
+			scalar_sum = sum;
+		} /* if */
+
+		printf( "kernel %-6s: %lu calls in %.3f seconds (%.1f ns/call)%s\n",
+			kernel_name[kernel], calls, elapsed, 1.0e9 * elapsed / calls,
+			( sum == scalar_sum ) ? "" : " DISAGREES WITH SCALAR" );
+	} /* for */
+
+	flip_kernel = saved;
+} /* run_kernel_bench() */
+
+
+/* With --probcut, compare the selective search with the full-width one
+ * at each depth up to max_ply: the nodes and time over the suite's
+ * positions that are not solved exactly, and how often the two choose
+ * the same move
+ */
+
+static void run_probcut_bench( search_type * searches,
+	unsigned int num_threads, unsigned int max_ply )
+{
+	player_data_type x_data, o_data, * player;
+	search_result_type result;
+	search_stats_type stats;
+	unsigned long nodes[2];
+	unsigned int i, depth, mode, num_positions, same,
+		full_move[NUM_BENCH_POSITIONS];
+	double start, elapsed[2];
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	for( depth = 1; depth <= max_ply; depth++ ) {
+		num_positions = same = 0;
+
+		for( mode = 0; mode < 2; mode++ ) {
+			probcut = ( mode == 1 ) ? TRUE : FALSE;
+			tt_clear( searches[0].tt );
+			nodes[mode] = 0;
+			elapsed[mode] = 0.0;
+
+			for( i = 0; i < NUM_BENCH_POSITIONS; i++ ) {
+				player = bench_position( i, &x_data );
+
+				if( BOARD_AREA - player->count - player->opponent->count
+					<= endgame_empties ) continue;
+
+				searches[0].rand_state = BENCH_SEED + i;
+				start = now_seconds();
+				search_root( searches, num_threads, player, depth, 0.0,
+					&result );
+				elapsed[mode] += now_seconds() - start;
+				sum_stats( searches, num_threads, &stats );
+				nodes[mode] += stats.node_count;
+
+				if( mode == 0 ) {
+					full_move[i] = result.pv.move[0];
+					num_positions++;
+				} else if( result.pv.move[0] == full_move[i] ) {
+					same++;
+				} /* if */
+			} /* for */
+		} /* for */
+
+		printf( "probcut depth %2u: full %9lu nodes %7.3f s, selective %9lu"
+			" nodes %7.3f s, same move %u/%u\n", depth, nodes[0], elapsed[0],
+			nodes[1], elapsed[1], same, num_positions );
+	} /* for */
+} /* run_probcut_bench() */
+
+
+static void run_bench( search_type * searches, unsigned int num_threads,
+	unsigned int max_ply )
+{
+	player_data_type x_data, o_data, * player;
+	search_result_type result;
+	search_stats_type stats;
+	unsigned long total_nodes = 0;
+	unsigned int i;
+	double start, elapsed, total_time = 0.0;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	for( i = 0; i < NUM_BENCH_POSITIONS; i++ ) {
+		player = bench_position( i, &x_data );
+		searches[0].rand_state = BENCH_SEED + i;
+		start = now_seconds();
+		search_root( searches, num_threads, player, max_ply, 0.0, &result );
+		elapsed = now_seconds() - start;
+		sum_stats( searches, num_threads, &stats );
+
+		printf( "bench %2u: move=%d,%d score=%d depth=%d nodes=%lu time=%.3f\n",
+			i + 1, result.pv.move[0] / BOARD_SIZE,
+			result.pv.move[0] % BOARD_SIZE, result.score, result.depth,
+			stats.node_count, elapsed );
+		total_nodes += stats.node_count;
+		total_time += elapsed;
+	} /* for */
+
+	printf( "bench: %lu nodes in %.3f seconds (%.0f nodes/second) with the"
+		" %s kernel\n", total_nodes, total_time,
+		( total_time > 0.0 ) ? total_nodes / total_time : 0.0,
+		kernel_name[flip_kernel] );
+	if( probcut ) {
+		run_probcut_bench( searches, num_threads, max_ply );
+	} /* if */
+
+	run_kernel_bench();
+} /* run_bench() */
+
+
+/* Self-play
+ * Two engines, differing only in search depth, play games from random
+ * openings.  Each opening is played twice, with the engines swapping
+ * colours.  Each engine has its own search record and transposition
+ * table, so that neither searches with what the other has learnt, and
+ * the position cache is not used.  Every game gets its own seeds and
+ * starts with clear tables, so without a time budget its result depends
+ * only on its number and the seed, however many games are played at once.
+ */
+
+typedef struct {
+	unsigned int num_games, next_game;
+	unsigned int depth[2];		/* The first and second engines' depths */
+	unsigned long seed;
+	double movetime;
+	unsigned int wins, draws, losses;	/* For the first engine */
+	unsigned long moves, nodes;
+	double move_time;		/* Spent searching, over all games */
+	pthread_mutex_t lock;
+} selfplay_type;
+
+typedef struct {
+	selfplay_type * selfplay;
+	search_type * search[2];	/* The first and second engines' */
+	tt_type tt[2];
+	pthread_t thread;
+} selfplay_worker_type;
+
+
+/* Play one game and return the first engine's final disc differential */
+
+static int play_game( selfplay_type * selfplay, search_type * engines[2],
+	unsigned int game, unsigned long * moves, unsigned long * nodes,
+	double * move_time )
+{
+	player_data_type x_data, o_data, * player;
+	move_type move_list[MAX_NUM_MOVES], move;
+	search_result_type result;
+	search_type * search;
+	uint64_t key = 0;
+	unsigned int first_id = game % 2, num_moves, ply, engine;
+	bool passed = FALSE;
+	double start;
+
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+	start_position( &x_data );
+	player = &x_data;
+
+	for( engine = 0; engine < 2; engine++ ) {
+		search = engines[engine];
+		tt_clear( search->tt );
+		memset( search->history, 0, sizeof( search->history ) );
+		search->rand_state = selfplay->seed * 1000003UL + game * 2 + engine;
+	} /* for */
+
+	/* Both games of a pair open alike */
+	search = engines[0];
+	search->rand_state = selfplay->seed + game / 2;
+
+	for( ply = 0; ply < SELFPLAY_OPENING; ply++ ) {
+		num_moves = generate_moves( player, move_list );
+
+		if( num_moves == 0 ) break;
+
+		apply_move( player, &move_list[search_rand( search ) % num_moves],
+			&key );
+		player = player->opponent;
+	} /* for */
+
+	search->rand_state = selfplay->seed * 1000003UL + game * 2;
+
+	for( ; ; ) {
+		num_moves = generate_moves( player, move_list );
+
+		if( num_moves == 0 ) {
+
+			if( passed ) break;
+
+			passed = TRUE;
+			player = player->opponent;
+			continue;
+		} /* if */
+
+		passed = FALSE;
+		engine = ( player->id == first_id ) ? 0 : 1;
+		search = engines[engine];
+		start = now_seconds();
+		search_root( search, 1, player, selfplay->depth[engine],
+			selfplay->movetime, &result );
+		*move_time += now_seconds() - start;
+		*nodes += search->stats.node_count;
+		++*moves;
+
+		move.sq = ( result.pv.length > 0 ) ? result.pv.move[0]
+			: move_list[0].sq;
+		move.flips = compute_flips( move.sq, player->discs,
+			player->opponent->discs );
+		apply_move( player, &move, &key );
+		player = player->opponent;
+	} /* for */
+
+	player = ( x_data.id == first_id ) ? &x_data : &o_data;
+	return( (int)player->count - (int)player->opponent->count );
+} /* play_game() */
+
+
+static void * selfplay_worker( void * arg )
+{
+	selfplay_worker_type * worker = (selfplay_worker_type *)arg;
+	selfplay_type * selfplay = worker->selfplay;
+	unsigned long moves, nodes;
+	unsigned int game;
+	double move_time;
+	int score;
+
+	worker->search[0]->tt = &worker->tt[0];
+	worker->search[1]->tt = &worker->tt[1];
+	pthread_mutex_lock( &selfplay->lock );
+
+	while( selfplay->next_game < selfplay->num_games ) {
+		game = selfplay->next_game++;
+		pthread_mutex_unlock( &selfplay->lock );
+
+		moves = nodes = 0;
+		move_time = 0.0;
+		score = play_game( selfplay, worker->search, game, &moves, &nodes,
+			&move_time );
+
+		pthread_mutex_lock( &selfplay->lock );
+
+		if( score > 0 ) {
+			selfplay->wins++;
+		} else if( score < 0 ) {
+			selfplay->losses++;
+		} else {
+			selfplay->draws++;
+		} /* if */
+
+		selfplay->moves += moves;
+		selfplay->nodes += nodes;
+		selfplay->move_time += move_time;
+		printf( "game %4u: first=%c score=%+d moves=%lu nodes=%lu time=%.3f\n",
+			game + 1, ( game % 2 == 0 ) ? 'X' : 'O', score, moves, nodes,
+			move_time );
+		fflush( stdout );
+	} /* while */
+
+	pthread_mutex_unlock( &selfplay->lock );
+	return( NULL );
+} /* selfplay_worker() */
+
+
+/* Play num_games games, num_threads at a time, and report the first
+ * engine's wins, draws and losses
+ */
+
+static void run_selfplay( search_type * searches, unsigned int num_threads,
+	unsigned int num_games, unsigned long seed, unsigned int depth,
+	unsigned int vs_depth, double movetime )
+{
+	selfplay_type selfplay;
+	selfplay_worker_type * workers;
+	search_type * second_engines;
+	unsigned int t, played;
+
+	workers = (selfplay_worker_type *)calloc( num_threads,
+		sizeof( selfplay_worker_type ) );
+	second_engines = (search_type *)calloc( num_threads,
+		sizeof( search_type ) );
+
+	if( workers == NULL  ||  second_engines == NULL ) {
+		fprintf( stderr, "Cannot allocate the self-play workers\n" );
+		exit( 1 );
+	} /* if */
+
+	/* It would hand one engine's results to the other */
+	cache = NULL;
 
-/* INIT_MAX_EFFECT should be less than the sum of the values of
- * the heuristic function for all board squares.
- */
-#define INIT_MAX_EFFECT	-9*BOARD_AREA
+	selfplay.num_games = num_games;
+	selfplay.next_game = 0;
+	selfplay.depth[0] = depth;
+	selfplay.depth[1] = vs_depth;
+	selfplay.seed = seed;
+	selfplay.movetime = movetime;
+	selfplay.wins = selfplay.draws = selfplay.losses = 0;
+	selfplay.moves = selfplay.nodes = 0;
+	selfplay.move_time = 0.0;
+	pthread_mutex_init( &selfplay.lock, NULL );
 
-/* Heuristic function */
-#define idx_weight(x)	((x==0||x==BOARD_SIZE-1)?BOARD_SIZE:1)
-#define h_func(r,c)	(idx_weight(r)*idx_weight(c))
+	for( t = 0; t < num_threads; t++ ) {
+		workers[t].selfplay = &selfplay;
+		workers[t].search[0] = &searches[t];
+		workers[t].search[1] = &second_engines[t];
+		tt_init( &workers[t].tt[0], (size_t)SELFPLAY_TT_MEGABYTES << 20 );
+		tt_init( &workers[t].tt[1], (size_t)SELFPLAY_TT_MEGABYTES << 20 );
 
-/* Define a boolean type */
+		if( pthread_create( &workers[t].thread, NULL, selfplay_worker,
+			&workers[t] ) != 0 ) {
 
-#ifndef FALSE
-#ifdef TRUE
-#undef TRUE
-#endif
-typedef enum { FALSE, TRUE } bool;
-#else
-#ifndef TRUE
-#define TRUE 1
-#endif
-typedef char bool;
-#endif
+			fprintf( stderr, "Cannot start self-play thread %d\n", t );
+			exit( 1 );
+		} /* if */
+	} /* for */
 
+	for( t = 0; t < num_threads; t++ ) {
+		pthread_join( workers[t].thread, NULL );
+		tt_free( &workers[t].tt[0] );
+		tt_free( &workers[t].tt[1] );
+		searches[t].tt = &shared_tt;
+	} /* for */
 
-/* Other type definitions */
+	played = selfplay.wins + selfplay.draws + selfplay.losses;
+	printf( "selfplay: depth %u vs %u, %u games: +%u =%u -%u (%.1f%%),"
+		" %.3f ms/move, %.0f nodes/game\n", depth, vs_depth, played,
+		selfplay.wins, selfplay.draws, selfplay.losses,
+		( played > 0 ) ? 100.0 * ( selfplay.wins + 0.5 * selfplay.draws )
+			/ played : 0.0,
+		( selfplay.moves > 0 ) ? 1000.0 * selfplay.move_time
+			/ selfplay.moves : 0.0,
+		( played > 0 ) ? (double)selfplay.nodes / played : 0.0 );
+	pthread_mutex_destroy( &selfplay.lock );
+	free( second_engines );
+	free( workers );
+} /* run_selfplay() */
 
-typedef enum {
-	PT_COMP,
-	PT_HUMAN
-} player_type_type;
+
+/* Server mode: "--server" answers requests on the standard input and
+ * output, and "--listen port" on TCP connections to the loopback address,
+ * one connection at a time.  A request is a line of text:
+ *   setposition start        ok
+ *   setposition position     ok (the position as for --analyze)
+ *   move r,c | move pass     ok, once played on the position
+ *   go [depth n] [movetime ms]
+ *                            starts a search of the position, answered
+ *                            when it ends by "bestmove" and the fields
+ *                            of --analyze (depth=0 for a book move)
+ *   stop                     ends the search early; its bestmove follows
+ *   stats                    the last search's counters, as --stats does,
+ *                            with the move pass or none as for bestmove
+ *   show                     position, and the position
+ *   newgame                  ok, once the transposition table is cleared
+ *   ping                     pong
+ *   quit                     stops the server
+ * A request that cannot be carried out gets "error" and a message.
+ * Requests other than stop, stats, ping and quit wait for the search under
+ * way to end.  The transposition table, the book, the cache and the
+ * evaluation weights stay loaded from one request and connection to the
+ * next.  At the end of a connection, its search is stopped.
+ */
+
+#define SERVER_LINE_SIZE	512
 
 typedef struct {
-	int drow, dcol;
-} vector_type;
+	search_type * searches;
+	unsigned int num_threads, max_ply;
+	double movetime;
+	player_data_type players[2];	/* The position; players[0] is X */
+	unsigned int mover_id;		/* The id of the player to move */
+	player_data_type searched[2];	/* The position being searched */
+	unsigned int searched_id, search_max_ply;
+	double search_movetime;
+	unsigned long num_searches;	/* Seeds the tie-breaking */
+	player_data_type last[2];	/* The position of the last search */
+	unsigned int last_id;
+	search_result_type result;	/* Its result */
+	search_stats_type stats;
+	double elapsed;
+	bool have_result, searching;
+	volatile bool interrupt;	/* Set to stop the search */
+	pthread_t thread;
+	pthread_mutex_t lock;		/* Guarding the last search's result */
+	FILE * out;
+} server_type;
 
-typedef struct coord_struct {
-	unsigned int r, c;
-	/* "tail" is a pointer to the "next" pointer of the last element
-	 * in the list.  This allows constant-time list splicing.
-	 */
-	struct coord_struct * next, ** tail;
-} coord_type;
 
-typedef struct player_data_struct {
-	char marker;
-	unsigned int count;		/* The number of its markers on the board */
-	player_type_type type;
-	struct player_data_struct * opponent;
-} player_data_type;
+/* Write a line of response; the search thread writes its own */
 
+static void server_reply( server_type * server, const char * line )
+{
+	flockfile( server->out );
+	fputs( line, server->out );
+	fputc( '\n', server->out );
+	fflush( server->out );
+	funlockfile( server->out );
+} /* server_reply() */
 
-/* Global variables
- * These could be moved into a structure, the pointer to which could be
- * passed as a parameter to the appropriate functions.
- */
 
-char board[BOARD_SIZE][BOARD_SIZE + 1];
-bool verbose;
-coord_type * local_heap = NULL;
+/* Make the players a pair again after copying them */
 
+static void link_players( player_data_type players[2] )
+{
+	players[0].opponent = &players[1];
+	players[1].opponent = &players[0];
+} /* link_players() */
 
-/* Add a list of move records to the application heap */
 
-static void enqueue( coord_type * ptr )
+static void * server_thread( void * arg )
 {
-	if( ptr == NULL ) return;
+	server_type * server = (server_type *)arg;
+	player_data_type * player = &server->searched[server->searched_id];
+	search_result_type result;
+	search_stats_type stats;
+	char line[SERVER_LINE_SIZE];
+	unsigned long nodes = 0;
+	unsigned int sq;
+	double elapsed = 0.0;
+	int score;
 
-	*(ptr->tail) = local_heap;
-#if 0
-	/* Not essential */
-	ptr->tail = &local_heap->tail; /* Keeps heap linked to its tail */
-#endif
-	local_heap = ptr;
-} /* enqueue() */
+	if( book_probe( player, server->num_searches * 2654435761UL, &sq,
+		&score ) ) {
+
+		result.score = score;
+		result.exact = FALSE;
+		result.depth = 0;
+		result.partial = FALSE;
+		result.pv.length = 1;
+		result.pv.move[0] = (uint8_t)sq;
+	} else {
+		analyze_position( player, server->num_searches, server->searches,
+			server->num_threads, server->search_max_ply,
+			server->search_movetime, &result, &nodes, &elapsed );
+	} /* if */
 
+	if( nodes > 0 ) {
+		sum_stats( server->searches, server->num_threads, &stats );
+	} else {
+		memset( &stats, 0, sizeof( stats ) );
+	} /* if */
+
+	/* A stats request may be reading the last search's */
+	pthread_mutex_lock( &server->lock );
+	server->last[0] = server->searched[0];
+	server->last[1] = server->searched[1];
+	link_players( server->last );
+	server->last_id = server->searched_id;
+	server->result = result;
+	server->stats = stats;
+	server->elapsed = elapsed;
+	server->have_result = TRUE;
+	pthread_mutex_unlock( &server->lock );
+
+	strcpy( line, "bestmove" );
+	print_analysis( line + 8, line + sizeof( line ), &result, nodes, elapsed );
+	line[strlen( line ) - 1] = '\0';	/* server_reply() ends the line */
+	server_reply( server, line );
+	return( NULL );
+} /* server_thread() */
 
-/* Get a blank move record, from the application heap or the real one */
 
-static coord_type * dequeue( void )
+/* Wait for the search under way to end, after stopping it if stop is set */
+
+static void server_wait( server_type * server, bool stop )
 {
-	coord_type * rtn;
+	if( !server->searching ) return;
 
-	if( local_heap == NULL ) {
-		return( (coord_type *)malloc( sizeof( coord_type ) ) );
+	if( stop ) {
+		server->interrupt = TRUE;
 	} /* if */
 
-	rtn = local_heap;
-	local_heap = local_heap->next;
-	return( rtn );
-} /* dequeue() */
+	pthread_join( server->thread, NULL );
+	server->searching = FALSE;
+	server->searches[0].interrupt = NULL;
+} /* server_wait() */
 
 
-/* Initialize a player's record.
- * This would make a wonderful constructor in C++
+/* Start searching the position, to the depth and for the time given in
+ * the rest of a go request
  */
 
-static void set_player_data( player_data_type * player )
+static void server_go( server_type * server, const char * args )
 {
-	char str[10];
+	char word[16];
+	double value;
+	int n;
 
-	/* Marker must already be set */
+	server->search_max_ply = server->max_ply;
+	server->search_movetime = server->movetime;
 
-	do {
-		printf( "%c: (h)uman or (c)omputer: ", player->marker );
-		scanf( "%s", str );
-	} while( str[0] != 'h'  &&  str[0] != 'c' );
+	for( ; sscanf( args, "%15s %lf%n", word, &value, &n ) == 2; args += n ) {
 
-	player->type = ( str[0] == 'h' ) ? PT_HUMAN : PT_COMP;
-} /* set_player_data() */
+		if( strcmp( word, "depth" ) == 0  &&  value >= 1
+			&&  value <= MAX_PLY ) {
 
+			server->search_max_ply = (unsigned int)value;
+		} else if( strcmp( word, "movetime" ) == 0  &&  value > 0 ) {
+			server->search_movetime = value / 1000.0;
+		} else {
+			server_reply( server, "error bad go request" );
+			return;
+		} /* if */
+	} /* for */
 
-/* Crude but highly portable output */
+	if( args[strspn( args, " \t" )] != '\0' ) {
+		server_reply( server, "error bad go request" );
+		return;
+	} /* if */
+
+	if( server->search_max_ply == 0 ) {
+		server->search_max_ply = ( server->search_movetime > 0.0 ) ? MAX_PLY
+			: BATCH_DEPTH;
+	} /* if */
+
+	server->searched[0] = server->players[0];
+	server->searched[1] = server->players[1];
+	link_players( server->searched );
+	server->searched_id = server->mover_id;
+	server->num_searches++;
+	server->interrupt = FALSE;
+	server->searches[0].interrupt = &server->interrupt;
+
+	if( pthread_create( &server->thread, NULL, server_thread, server ) != 0 ) {
+		server->searches[0].interrupt = NULL;
+		server_reply( server, "error cannot start the search" );
+		return;
+	} /* if */
+
+	server->searching = TRUE;
+} /* server_go() */
+
+
+/* Play a move, "r,c" or "pass", on the position */
 
-static void draw_board( void )
+static void server_move( server_type * server, const char * args )
 {
-	unsigned int row;
+	player_data_type * player = &server->players[server->mover_id];
+	move_type move;
+	uint64_t key = 0;
+	unsigned int row, col;
 
-	printf( "\n       01234567\n" );
-	printf( "      +--------+\n" );
+	if( strncmp( args, "pass", 4 ) == 0 ) {
 
-	for( row = 0; row < BOARD_SIZE; row++ ) {
-		printf( "    %1d |%s|\n", row, board[row] );
-	} /* for */
+		if( legal_moves( player->discs, player->opponent->discs ) != 0 ) {
+			server_reply( server, "error a move is possible" );
+			return;
+		} /* if */
+	} else {
 
-	printf( "      +--------+\n\n\n" );
-} /* draw_board() */
+		if( sscanf( args, "%u,%u", &row, &col ) != 2  ||  row >= BOARD_SIZE
+			||  col >= BOARD_SIZE  ||  ( ( player->discs
+				| player->opponent->discs ) & SQUARE_BIT( SQUARE(row,col) ) )
+					!= 0 ) {
 
+			server_reply( server, "error illegal move" );
+			return;
+		} /* if */
 
-/* Using a heuristic, compute the gain resulting from a player's move. */
+		move.sq = SQUARE(row,col);
+		move.flips = compute_flips( move.sq, player->discs,
+			player->opponent->discs );
 
-static unsigned int compute_effect( unsigned int row, unsigned int col,
-	player_data_type * player,
-	char * changes[MAX_CHANGES], unsigned int * num_changedP )
+		if( move.flips == 0 ) {
+			server_reply( server, "error illegal move" );
+			return;
+		} /* if */
+
+		apply_move( player, &move, &key );
+	} /* if */
+
+	server->mover_id = player->opponent->id;
+	server_reply( server, "ok" );
+} /* server_move() */
+
+
+/* Answer the requests read from in, on out, until the end of in or quit.
+ * Returns TRUE after quit.
+ */
+
+static bool serve( server_type * server, FILE * in, FILE * out )
 {
-	char * line_change[BOARD_SIZE-1];
-	unsigned int row2, col2, num_changed = 0, i, heur_total=0, line_heur_total,
-		len, drow, dcol, j;
-	static vector_type vector[NUM_VECTORS] = { {-1,-1}, {-1,0}, {-1,1}, {0,-1},
-											   {0,1}, {1,-1}, {1,0}, {1,1} };
+	player_data_type players[2], * player;
+	char line[SERVER_LINE_SIZE], output[SERVER_LINE_SIZE], * args;
+	bool quit = FALSE;
 
-	for( i = 0; i < NUM_VECTORS; i++ ) {
-		len = line_heur_total = 0;
-		row2 = row;
-		col2 = col;
-		drow = vector[i].drow;
-		dcol = vector[i].dcol;
+	server->out = out;
 
-		for( ; ; ) {
-			row2 += drow;
-			col2 += dcol;
+	while( !quit  &&  fgets( line, sizeof( line ), in ) != NULL ) {
+		line[strcspn( line, "\r\n" )] = '\0';
 
-			if( row2 >= BOARD_SIZE  ||  col2 >= BOARD_SIZE
-				||  board[row2][col2] == ' ' ) {
+		/* Split the request from its arguments */
+		for( args = line; *args != '\0'  &&  !isspace( (unsigned char)*args );
+			args++ ) {
+		} /* for */
 
-				len = 0;
-				break;
-			} else if( board[row2][col2] == player->marker ) break;
+		if( *args != '\0' ) *args++ = '\0';
 
-			line_heur_total += h_func(row2,col2);
-			assert( len < BOARD_SIZE - 1 );
-			line_change[len++] = &board[row2][col2];
+		for( ; isspace( (unsigned char)*args ); args++ ) {
 		} /* for */
 
-		if( len > 0 ) {
+		if( line[0] == '\0' ) {
+			continue;
+		} else if( strcmp( line, "stop" ) == 0 ) {
+			server_wait( server, TRUE );
+		} else if( strcmp( line, "ping" ) == 0 ) {
+			server_reply( server, "pong" );
+		} else if( strcmp( line, "quit" ) == 0 ) {
+			quit = TRUE;
+		} else if( strcmp( line, "stats" ) == 0 ) {
+			pthread_mutex_lock( &server->lock );
 
-			for( j = 0; j < len; j++ ) {
-				*(line_change[j]) = player->marker;
-			} /* for */
+			if( !server->have_result ) {
+				server_reply( server, "error no search yet" );
+			} else {
+				flockfile( out );
+				print_stats( out, &server->stats,
+					&server->last[server->last_id], &server->result,
+					server->elapsed );
+				funlockfile( out );
+			} /* if */
+
+			pthread_mutex_unlock( &server->lock );
+		} else {
+			server_wait( server, FALSE );
+
+			if( strcmp( line, "go" ) == 0 ) {
+				server_go( server, args );
+			} else if( strcmp( line, "move" ) == 0 ) {
+				server_move( server, args );
+			} else if( strcmp( line, "setposition" ) == 0 ) {
+
+				players[0] = server->players[0];
+				players[1] = server->players[1];
+				link_players( players );
+
+				if( strcmp( args, "start" ) == 0 ) {
+					start_position( &players[0] );
+					player = &players[0];
+				} else {
+					player = ( strlen( args ) > BOARD_AREA )
+						? parse_position( args, &players[0] ) : NULL;
+				} /* if */
 
-			assert( num_changed + len <= MAX_CHANGES );
-			memcpy( &changes[num_changed], line_change, len * sizeof(char *) );
-			num_changed += len;
-			heur_total += line_heur_total;
+				if( player == NULL ) {
+					server_reply( server, "error not a position" );
+				} else {
+					server->players[0] = players[0];
+					server->players[1] = players[1];
+					link_players( server->players );
+					server->mover_id = player->id;
+					server_reply( server, "ok" );
+				} /* if */
+			} else if( strcmp( line, "show" ) == 0 ) {
+				strcpy( output, "position " );
+				print_position( output + 9, &server->players[0],
+					&server->players[server->mover_id] );
+				server_reply( server, output );
+			} else if( strcmp( line, "newgame" ) == 0 ) {
+				tt_clear( server->searches[0].tt );
+				server_reply( server, "ok" );
+			} else {
+				server_reply( server, "error unknown request" );
+			} /* if */
 		} /* if */
-	} /* for */
+	} /* while */
+
+	server_wait( server, TRUE );
+	return( quit );
+} /* serve() */
+
 
-	if( num_changed > 0 ) {
-		heur_total += h_func(row,col);
-		board[row][col] = player->marker;	/* Place marker now */
-		player->count += num_changed + 1;
-		player->opponent->count -= num_changed;
+/* Run the server on the standard input and output, or on connections to
+ * the given TCP port (when not 0) until a quit request
+ */
+
+static void run_server( search_type * searches, unsigned int num_threads,
+	unsigned int max_ply, double movetime, unsigned int port )
+{
+	server_type server;
+	struct sockaddr_in address;
+	int listener, connection, one = 1;
+	FILE * in, * out;
+	bool quit = FALSE;
+
+	memset( &server, 0, sizeof( server ) );
+	server.searches = searches;
+	server.num_threads = num_threads;
+	server.max_ply = max_ply;
+	server.movetime = movetime;
+	server.players[0].marker = 'X';
+	server.players[1].marker = 'O';
+	server.players[0].id = 0;
+	server.players[1].id = 1;
+	link_players( server.players );
+	start_position( &server.players[0] );
+	server.mover_id = 0;
+	pthread_mutex_init( &server.lock, NULL );
+
+	if( port == 0 ) {
+		serve( &server, stdin, stdout );
+		return;
 	} /* if */
 
-	if( num_changedP != NULL ) {
-		*num_changedP = num_changed;
+	listener = socket( AF_INET, SOCK_STREAM, 0 );
+	memset( &address, 0, sizeof( address ) );
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	address.sin_port = htons( (unsigned short)port );
+
+	if( listener < 0
+		||  setsockopt( listener, SOL_SOCKET, SO_REUSEADDR, &one,
+			sizeof( one ) ) != 0
+		||  bind( listener, (struct sockaddr *)&address,
+			sizeof( address ) ) != 0
+		||  listen( listener, 4 ) != 0 ) {
+
+		fprintf( stderr, "Cannot listen on port %u\n", port );
+		exit( 1 );
 	} /* if */
 
-	return( heur_total );
-} /* compute_effect() */
+	/* A client that leaves mid-reply must not end the server */
+	signal( SIGPIPE, SIG_IGN );
 
+	while( !quit ) {
+		connection = accept( listener, NULL, NULL );
 
-/* Compute the best-move chain (according to the minimax algorithm)
- */
+		if( connection < 0 ) continue;
+
+		in = fdopen( connection, "r" );
+		out = fdopen( dup( connection ), "w" );
+
+		if( in == NULL  ||  out == NULL ) {
+			fprintf( stderr, "Cannot serve a connection\n" );
+			exit( 1 );
+		} /* if */
+
+		quit = serve( &server, in, out );
+		fclose( in );
+		fclose( out );
+	} /* while */
+
+	close( listener );
+} /* run_server() */
 
-static int best_move( coord_type ** rtn_chain,
-	player_data_type * player,
-	unsigned int ply, unsigned int max_ply, int prev_move_val, int best_sibling )
+
+static void usage( void )
 {
-	bool done = FALSE;
-	char * changes[MAX_CHANGES];
-	int effect, max_effect = INIT_MAX_EFFECT;
-	unsigned int num_changes, i, j, k, num_best_moves = 0, chosen_move;
-	coord_type * best_moves[MAX_NUM_MOVES], * chain_ptr = NULL, * move_ptr;
+	fprintf( stderr, "usage: othello [--movetime milliseconds] [--depth n]"
+		" [--threads n] [--endgame empties]\n"
+		"               [--hash megabytes]\n"
+		"               [--eval patterns|file] [--save-eval file]"
+		" [--stats file]\n"
+		"               [--kernel scalar|avx2|neon] [--book file]"
+		" [--build-book file] [--ponder]\n"
+		"               [--analyze file [--binary] | --perft depth"
+		" [--position pos] | --bench]\n"
+		"               [--to-binary file | --to-text file [--draw]]\n"
+		"               [--server | --listen port]\n"
+		"               [--selfplay games [--seed n] [--vs-depth n]]\n"
+		"               [--probcut file] [--fit-probcut file]"
+		" [--cache file [--cache-size megabytes]]\n" );
+	exit( 1 );
+} /* usage() */
 
-	for( i = 0; i < BOARD_SIZE  &&  !done; i++ ) {
 
-		for( j = 0; j < BOARD_SIZE  &&  !done; j++ ) {
+int main( int argc, char * argv[] )
+{
+	bool can_go = TRUE, prev_can_go, done = FALSE, pause_after, ponder_hit;
+	char str[10];
+	int effect, arg;
+	unsigned int i, row, col, num_changed, max_ply = 0,
+		num_threads = 1, perft_depth = 0, book_sq,
+		selfplay_games = 0, vs_depth = 0, hash_megabytes = TT_MEGABYTES,
+		listen_port = 0, cache_megabytes = 0;
+	unsigned long seed = SELFPLAY_SEED;
+	double movetime = 0.0, start, elapsed;
+	const char * analyze_name = NULL, * position = NULL,
+		* eval_name = NULL, * save_eval_name = NULL, * kernel_choice = NULL,
+		* book_name = NULL, * build_book_name = NULL,
+		* probcut_name = NULL, * fit_probcut_name = NULL,
+		* cache_name = NULL, * to_binary_name = NULL, * to_text_name = NULL,
+		* convert_name;
+	kernel_type kernel;
+	bool bench = FALSE, pondering = FALSE, binary = FALSE, draw = FALSE,
+		server = FALSE;
+	FILE * in, * stats_file = NULL;
+	ponder_type ponder;
+	player_data_type x_data, o_data, * player, * player_ptr;
+	move_type move_list[MAX_NUM_MOVES];
+	search_result_type result;
+	search_stats_type stats;
+	search_type * searches;
 
-			if( board[i][j] != ' ' ) continue;
+	for( arg = 1; arg < argc; arg++ ) {
 
-			/* Make and record changes */
-			effect = compute_effect( i, j, player, changes, &num_changes );
+		if( strcmp( argv[arg], "--movetime" ) == 0  &&  arg + 1 < argc ) {
+			movetime = atof( argv[++arg] ) / 1000.0;
 
-			if( num_changes == 0 ) continue;
+			if( movetime <= 0.0 ) usage();
+		} else if( strcmp( argv[arg], "--threads" ) == 0  &&  arg + 1 < argc ) {
+			num_threads = atoi( argv[++arg] );
 
-			if( verbose ) {
-				printf( "Ply %d: %c placed at (%d,%d)\n", ply, player->marker,
-					i, j );
-			} /* if */
+			if( num_threads < 1  ||  num_threads > MAX_THREADS ) usage();
+		} else if( strcmp( argv[arg], "--hash" ) == 0  &&  arg + 1 < argc ) {
+			hash_megabytes = atoi( argv[++arg] );
 
-			if( ply < max_ply  &&
-				player->count + player->opponent->count < BOARD_AREA ) {
+			if( hash_megabytes < 1 ) usage();
+		} else if( strcmp( argv[arg], "--endgame" ) == 0  &&  arg + 1 < argc ) {
+			endgame_empties = atoi( argv[++arg] );
 
-				effect -= best_move( &chain_ptr, player->opponent,
-					ply + 1, max_ply, effect, max_effect );
+			if( endgame_empties > ENDGAME_MAX_EMPTIES ) usage();
+		} else if( strcmp( argv[arg], "--depth" ) == 0  &&  arg + 1 < argc ) {
+			max_ply = atoi( argv[++arg] );
 
-				/* Insure that no moves are incorrectly ignored */
-				assert( effect > INIT_MAX_EFFECT );
-			} /* if */
+			if( max_ply < 1  ||  max_ply > MAX_PLY ) usage();
+		} else if( strcmp( argv[arg], "--analyze" ) == 0  &&  arg + 1 < argc ) {
+			analyze_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--binary" ) == 0 ) {
+			binary = TRUE;
+		} else if( strcmp( argv[arg], "--to-binary" ) == 0  &&  arg + 1 < argc ) {
+			to_binary_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--to-text" ) == 0  &&  arg + 1 < argc ) {
+			to_text_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--draw" ) == 0 ) {
+			draw = TRUE;
+		} else if( strcmp( argv[arg], "--perft" ) == 0  &&  arg + 1 < argc ) {
+			perft_depth = atoi( argv[++arg] );
 
-			if( effect > max_effect ) {
+			if( perft_depth < 1 ) usage();
+		} else if( strcmp( argv[arg], "--position" ) == 0  &&  arg + 1 < argc ) {
+			position = argv[++arg];
+		} else if( strcmp( argv[arg], "--bench" ) == 0 ) {
+			bench = TRUE;
+		} else if( strcmp( argv[arg], "--selfplay" ) == 0  &&  arg + 1 < argc ) {
+			selfplay_games = atoi( argv[++arg] );
 
-				for( k = 0; k < num_best_moves; k++ ) {
-					enqueue( best_moves[k] ); /* Enqueue old best chains */
-				} /* for */
+			if( selfplay_games < 1 ) usage();
+		} else if( strcmp( argv[arg], "--seed" ) == 0  &&  arg + 1 < argc ) {
+			seed = strtoul( argv[++arg], NULL, 10 );
+		} else if( strcmp( argv[arg], "--vs-depth" ) == 0  &&  arg + 1 < argc ) {
+			vs_depth = atoi( argv[++arg] );
 
-				if( ply > 1  &&  prev_move_val - effect < best_sibling ) {
-					/* Alpha-beta pruning is done here */
+			if( vs_depth < 1  ||  vs_depth > MAX_PLY ) usage();
+		} else if( strcmp( argv[arg], "--probcut" ) == 0  &&  arg + 1 < argc ) {
+			probcut_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--fit-probcut" ) == 0
+			&&  arg + 1 < argc ) {
 
-					if( verbose ) {
-						printf( "prune: %d - %d < %d\n", prev_move_val, effect,
-							best_sibling );
-					} /* if */
+			fit_probcut_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--cache" ) == 0  &&  arg + 1 < argc ) {
+			cache_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--cache-size" ) == 0
+			&&  arg + 1 < argc ) {
 
-					done = TRUE;
-				} /* if */
+			cache_megabytes = atoi( argv[++arg] );
+
+			if( cache_megabytes < 1 ) usage();
+		} else if( strcmp( argv[arg], "--server" ) == 0 ) {
+			server = TRUE;
+		} else if( strcmp( argv[arg], "--listen" ) == 0  &&  arg + 1 < argc ) {
+			listen_port = atoi( argv[++arg] );
+			server = TRUE;
+
+			if( listen_port < 1  ||  listen_port > 65535 ) usage();
+		} else if( strcmp( argv[arg], "--ponder" ) == 0 ) {
+			pondering = TRUE;
+		} else if( strcmp( argv[arg], "--book" ) == 0  &&  arg + 1 < argc ) {
+			book_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--build-book" ) == 0  &&  arg + 1 < argc ) {
+			build_book_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--kernel" ) == 0  &&  arg + 1 < argc ) {
+			kernel_choice = argv[++arg];
+		} else if( strcmp( argv[arg], "--eval" ) == 0  &&  arg + 1 < argc ) {
+			eval_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--save-eval" ) == 0  &&  arg + 1 < argc ) {
+			save_eval_name = argv[++arg];
+		} else if( strcmp( argv[arg], "--stats" ) == 0  &&  arg + 1 < argc ) {
+			arg++;
+			stats_file = ( strcmp( argv[arg], "-" ) == 0 ) ? stdout
+				: fopen( argv[arg], "a" );
 
-				max_effect = effect;
-				num_best_moves = 0;
+			if( stats_file == NULL ) {
+				fprintf( stderr, "Cannot open %s\n", argv[arg] );
+				exit( 1 );
 			} /* if */
+		} else {
+			usage();
+		} /* if */
+	} /* for */
 
-			if( effect == max_effect ) {
-				move_ptr = dequeue();
-				move_ptr->r = i;
-				move_ptr->c = j;
-				move_ptr->next = chain_ptr;
-				move_ptr->tail = (chain_ptr != NULL) ? chain_ptr->tail
-					: &move_ptr->next;
-				best_moves[num_best_moves++] = move_ptr;
-			} else {
-				enqueue( chain_ptr );	/* Return chain to heap */
+#ifdef PROFILE
+	atexit( profile_report );
+#endif
+	init_zobrist();
+	init_board_tables();
+	init_kernels();
+	init_endgame();
+	init_symmetries();
+
+	if( build_book_name != NULL ) {
+
+		if( !build_book( stdin, build_book_name ) ) {
+			fprintf( stderr, "Cannot write %s\n", build_book_name );
+			exit( 1 );
+		} /* if */
+
+		return( 0 );
+	} /* if */
+
+	if( to_binary_name != NULL  ||  to_text_name != NULL ) {
+		convert_name = ( to_binary_name != NULL ) ? to_binary_name
+			: to_text_name;
+		in = ( strcmp( convert_name, "-" ) == 0 ) ? stdin
+			: fopen( convert_name, ( to_binary_name != NULL ) ? "r" : "rb" );
+
+		if( in == NULL ) {
+			fprintf( stderr, "Cannot open %s\n", convert_name );
+			exit( 1 );
+		} /* if */
+
+		if( to_binary_name != NULL ) {
+
+			if( isatty( fileno( stdout ) ) ) {
+				fprintf( stderr, "Will not write records to a terminal\n" );
+				exit( 1 );
 			} /* if */
 
-			/* Remove marker and undo changes */
+			positions_to_records( in );
+		} else if( !records_to_text( in, draw ) ) {
+			fprintf( stderr, "%s does not hold records for this board size\n",
+				to_text_name );
+			exit( 1 );
+		} /* if */
+
+		return( 0 );
+	} /* if */
 
-			board[i][j] = ' ';
-			player->count -= num_changes + 1;
-			player->opponent->count += num_changes;
+	if( book_name != NULL  &&  !book_open( book_name ) ) {
+		fprintf( stderr, "Cannot use %s as an opening book\n", book_name );
+		exit( 1 );
+	} /* if */
 
-			for( k = 0; k < num_changes; k++ ) {
-				*(changes[k]) = player->opponent->marker;
-			} /* for */
-		} /* for j */
-	} /* for i */
-
-	if( rtn_chain == NULL ) {
-		/* Do nothing; don't retrieve best-move chain */
-	} else if( num_best_moves == 0 ) {
-		printf( "Ply %d: no best move chosen\n", ply );
-		*rtn_chain = NULL;
-		max_effect = 0;
-	} else {
-		chosen_move = rand() % num_best_moves;
-		*rtn_chain = best_moves[chosen_move];
+	if( kernel_choice != NULL ) {
 
-		for( i = 0; i < num_best_moves; i++ ) { /* Free other chains */
+		for( kernel = KERNEL_SCALAR; kernel <= KERNEL_NEON
+			&&  strcmp( kernel_choice, kernel_name[kernel] ) != 0; kernel++ ) {
+		} /* for */
+
+		if( kernel > KERNEL_NEON  ||  !select_kernel( kernel ) ) {
+			fprintf( stderr, "The %s kernel is not available\n",
+				kernel_choice );
+			exit( 1 );
+		} /* if */
+	} /* if */
+
+	if( ( eval_name != NULL  ||  save_eval_name != NULL )
+		&&  !init_eval( ( eval_name == NULL
+			||  strcmp( eval_name, "patterns" ) == 0 ) ? NULL : eval_name ) ) {
+
+		fprintf( stderr, "Cannot load the evaluation weights from %s\n",
+			eval_name );
+		exit( 1 );
+	} /* if */
+
+	if( probcut_name != NULL  &&  !load_probcut( probcut_name ) ) {
+		fprintf( stderr, "Cannot read the ProbCut pairs from %s\n",
+			probcut_name );
+		exit( 1 );
+	} /* if */
+
+	if( cache_name != NULL  &&  !cache_open( cache_name, cache_megabytes ) ) {
+		fprintf( stderr, "Cannot use %s as a position cache\n", cache_name );
+		exit( 1 );
+	} /* if */
+
+	if( save_eval_name != NULL ) {
+
+		if( !save_eval( save_eval_name ) ) {
+			fprintf( stderr, "Cannot write %s\n", save_eval_name );
+			exit( 1 );
+		} /* if */
+
+		return( 0 );
+	} /* if */
 
-			if( i != chosen_move ) {
-				enqueue( best_moves[i] );
+	tt_init( &shared_tt, (size_t)hash_megabytes << 20 );
+	searches = (search_type *)calloc( num_threads, sizeof( search_type ) );
+
+	if( searches == NULL ) {
+		fprintf( stderr, "Cannot allocate the search records\n" );
+		exit( 1 );
+	} /* if */
+
+	for( i = 0; i < num_threads; i++ ) {
+		searches[i].tt = &shared_tt;
+	} /* for */
+
+	ponder.active = FALSE;
+	x_data.marker = 'X';
+	o_data.marker = 'O';
+	x_data.id = 0;
+	o_data.id = 1;
+	x_data.opponent = &o_data;
+	o_data.opponent = &x_data;
+
+	if( server ) {
+		run_server( searches, num_threads, max_ply, movetime, listen_port );
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
+	} /* if */
+
+	if( perft_depth > 0 ) {
+		player = &x_data;
+		start_position( &x_data );
+
+		if( position != NULL ) {
+			player = ( strlen( position ) > BOARD_AREA )
+				? parse_position( position, &x_data ) : NULL;
+
+			if( player == NULL ) {
+				fprintf( stderr, "Not a position: %s\n", position );
+				exit( 1 );
 			} /* if */
 		} /* if */
 
-		if( verbose ) {
-			printf( "Chose move %d of %d\n", chosen_move, num_best_moves );
-			printf( "Ply %d: %c @ (%d,%d) => %d\n", ply, player->marker,
-				(*rtn_chain)->r, (*rtn_chain)->c, max_effect );
+		run_perft( player, perft_depth );
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
+	} /* if */
+
+	if( bench ) {
+		run_bench( searches, num_threads, ( max_ply > 0 ) ? max_ply
+			: BENCH_DEPTH );
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
+	} /* if */
+
+	if( selfplay_games > 0 ) {
+
+		if( max_ply == 0 ) {
+			max_ply = ( movetime > 0.0 ) ? MAX_PLY : SELFPLAY_DEPTH;
+		} /* if */
+
+		run_selfplay( searches, num_threads, selfplay_games, seed, max_ply,
+			( vs_depth > 0 ) ? vs_depth : max_ply, movetime );
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
+	} /* if */
+
+	if( fit_probcut_name != NULL ) {
+		in = ( strcmp( fit_probcut_name, "-" ) == 0 ) ? stdin
+			: fopen( fit_probcut_name, "r" );
+
+		if( in == NULL ) {
+			fprintf( stderr, "Cannot open %s\n", fit_probcut_name );
+			exit( 1 );
+		} /* if */
+
+		fit_probcut( in, searches, ( max_ply > 0 ) ? max_ply : BATCH_DEPTH );
+
+		if( in != stdin ) {
+			fclose( in );
 		} /* if */
+
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
 	} /* if */
 
-	return( max_effect );
-} /* best_move() */
+	if( analyze_name != NULL ) {
 
+		if( max_ply == 0 ) {
+			/* With a time budget, the depth is limited only by the clock */
+			max_ply = ( movetime > 0.0 ) ? MAX_PLY : BATCH_DEPTH;
+		} /* if */
 
-unsigned int main( void )
-{
-	bool can_go = TRUE, prev_can_go, done = FALSE, pause_after;
-	char * changes[MAX_CHANGES], str[10];
-	int effect;
-	unsigned int i, row, col, num_changed, max_ply;
-	player_data_type x_data, o_data, * player, * player_ptr;
-	coord_type * chain_ptr, * move_ptr;
+		in = ( strcmp( analyze_name, "-" ) == 0 ) ? stdin
+			: fopen( analyze_name, binary ? "rb" : "r" );
+
+		if( in == NULL ) {
+			fprintf( stderr, "Cannot open %s\n", analyze_name );
+			exit( 1 );
+		} /* if */
+
+		if( binary  &&  isatty( fileno( stdout ) ) ) {
+			fprintf( stderr, "Will not write records to a terminal\n" );
+			exit( 1 );
+		} /* if */
+
+		if( !analyze_positions( in, binary, searches, num_threads, max_ply,
+			movetime ) ) {
+
+			fprintf( stderr, "%s does not hold position records for this"
+				" board size\n", analyze_name );
+			exit( 1 );
+		} /* if */
+
+		if( in != stdin ) {
+			fclose( in );
+		} /* if */
+
+		free( searches );
+		tt_free( &shared_tt );
+		return( 0 );
+	} /* if */
 
 	printf( "verbose? " );
 	scanf( "%s", str );
 	verbose = (str[0] == 'y') ? TRUE : FALSE;
 
-	do {
+#ifndef TRACE
+	if( verbose ) {
+		printf( "(Compile with -DTRACE to trace every node of the search)\n" );
+	} /* if */
+#endif
+
+	if( movetime > 0.0  &&  max_ply == 0 ) {
+		/* With a time budget, the depth is limited only by the clock */
+		max_ply = MAX_PLY;
+	} /* if */
+
+	while( max_ply == 0 ) {
 		printf( "Enter skill level (1-10): " );
 		scanf( "%d", &max_ply );
-	} while( max_ply < 1  ||  max_ply > 10 );
 
-	x_data.marker = 'X';
-	o_data.marker = 'O';
-	x_data.opponent = &o_data;
-	o_data.opponent = &x_data;
+		if( max_ply < 1  ||  max_ply > 10 ) {
+			max_ply = 0;
+		} /* if */
+	} /* while */
+
 	set_player_data( &x_data );
 	set_player_data( &o_data );
 
@@ -362,17 +5533,10 @@ unsigned int main( void )
 	scanf( "%s", str );
 	pause_after = (str[0] == 'n') ? FALSE : TRUE;
 
-	for( i = 0; i < BOARD_SIZE; i++ ) {
-		memset( board[i], ' ', BOARD_SIZE );
-		board[i][BOARD_SIZE] = '\0';
-	} /* for */
-
-	board[3][3] = board[4][4] = x_data.marker;
-	board[3][4] = board[4][3] = o_data.marker;
-	x_data.count = o_data.count = 2;
+	start_position( &x_data );
 
 	player = &x_data;
-	draw_board();
+	draw_board( &x_data );
 
 	printf( "Enter: row, column (comma-separated) (both in range 0-%d)\n",
 		BOARD_SIZE-1 );
@@ -380,11 +5544,11 @@ unsigned int main( void )
 	do {
 		prev_can_go = can_go;
 		printf( "Checking viability...\n" );
-		can_go = ( best_move( &chain_ptr, player, 1, 1, 0, 0 )
-			> 0 ) ? TRUE : FALSE;
+		can_go = ( generate_moves( player, move_list ) > 0 ) ? TRUE : FALSE;
 
 		if( !can_go ) {
 			printf( "%c cannot move\n", player->marker );
+			ponder_finish( &ponder, NULL, &result );
 
 			if( !prev_can_go ) {
 				printf( "Deadlock: game terminated\n" );
@@ -406,10 +5570,13 @@ unsigned int main( void )
 					break;
 				} else if( toupper(str[0]) == 'H' ) {
 					/* Computer finds player's best move */
-					effect = best_move( &chain_ptr, player, 1, max_ply,0,0 );
-					printf( "Suggest (%d,%d) with an effect of %d\n\n",
-					chain_ptr->r, chain_ptr->c, effect );
-					enqueue( chain_ptr );
+					ponder_finish( &ponder, NULL, &result );
+					effect = search_root( searches, num_threads, player,
+						max_ply, movetime, &result );
+					printf( "Suggest (%d,%d) with %s of %d\n\n",
+						result.pv.move[0] / BOARD_SIZE,
+						result.pv.move[0] % BOARD_SIZE, result.exact
+						? "a final disc differential" : "an effect", effect );
 					continue;
 				} /* if */
 
@@ -420,14 +5587,17 @@ unsigned int main( void )
 					continue;
 				} /* if */
 
-				if( board[row][col] != ' ' ) {
+				if( ( (x_data.discs | o_data.discs)
+					& SQUARE_BIT( SQUARE(row,col) ) ) != 0 ) {
 					printf("That position already occupied; try again:\n");
 				} else {
-					effect = compute_effect( row, col, player, changes, NULL );
+					effect = compute_effect( row, col, player );
 
 					if( effect == 0 ) { /* heur==0 => #ch'd == 0 */
 						printf( "Zero-yield move; try again:\n" );
-					} else break;		/* Move is OK */
+					} else {		/* Move is OK */
+						break;
+					} /* if */
 				} /* if */
 			} /* for */
 
@@ -435,22 +5605,75 @@ unsigned int main( void )
 
 		} else {	/* Computer's move */
 			printf( "Computer is moving...\n" );
+			start = now_seconds();
+			ponder_hit = ponder_finish( &ponder, player, &result );
 			srand( time( NULL ) );
-			effect = best_move( &chain_ptr, player, 1, max_ply, 0, 0 );
-			printf( "Computer's move: %c placed at %d, %d\n",
-				player->marker, chain_ptr->r, chain_ptr->c );
-			compute_effect( chain_ptr->r, chain_ptr->c, player, changes, NULL);
+			searches[0].rand_state = rand();
 
-			printf( "Optimal chain:\n" );
+			if( !ponder_hit
+				&&  book_probe( player, rand(), &book_sq, &effect ) ) {
+				printf( "Computer's move: %c placed at %d, %d, from the book"
+					" (score %d)\n", player->marker, book_sq / BOARD_SIZE,
+					book_sq % BOARD_SIZE, effect );
+				effect = compute_effect( book_sq / BOARD_SIZE,
+					book_sq % BOARD_SIZE, player );
+			} else {
+				if( ponder_hit ) {
+					printf( "Ponder hit: the reply was searched in advance\n" );
+					effect = result.score;
+				} else {
+					effect = search_root( searches, num_threads, player,
+						max_ply, movetime, &result );
+				} /* if */
 
-			for( move_ptr = chain_ptr, player_ptr = player; move_ptr != NULL;
-				move_ptr = move_ptr->next, player_ptr = player_ptr->opponent ) {
+				elapsed = now_seconds() - start;
+				printf( "Computer's move: %c placed at %d, %d\n",
+					player->marker, result.pv.move[0] / BOARD_SIZE,
+					result.pv.move[0] % BOARD_SIZE );
+				printf( "Searched to depth %d%s in %.3f seconds\n", result.depth,
+					result.partial ? ", and part of the next," : "", elapsed );
 
-				printf( "%c: (%d,%d)\n", player_ptr->marker, move_ptr->r,
-					move_ptr->c );
-			} /* for */
+				if( result.exact ) {
+					printf( "Solved exactly: final disc differential %+d\n",
+						effect );
+				} /* if */
+
+				sum_stats( searches, num_threads, &stats );
+
+				if( stats.cache_hits > 0 ) {
+					printf( "Taken from the position cache\n" );
+				} else {
+					printf( "Cutoffs: %lu in %lu nodes (%.1f%%), %.1f%% of"
+						" them on the first move\n", stats.cutoff_count,
+						stats.node_count,
+						100.0 * stats.cutoff_count / stats.node_count,
+						( stats.cutoff_count > 0 ) ? 100.0
+							* stats.first_move_cutoffs / stats.cutoff_count
+							: 0.0 );
+				} /* if */
+
+				if( stats_file != NULL ) {
+					print_stats( stats_file, &stats, player, &result, elapsed );
+				} /* if */
+
+				compute_effect( result.pv.move[0] / BOARD_SIZE,
+					result.pv.move[0] % BOARD_SIZE, player );
 
-			enqueue( chain_ptr ); /* Reuse the chain of move records */
+				printf( "Optimal chain:\n" );
+
+				for( i = 0, player_ptr = player; i < result.pv.length;
+					i++, player_ptr = player_ptr->opponent ) {
+
+					printf( "%c: (%d,%d)\n", player_ptr->marker,
+						result.pv.move[i] / BOARD_SIZE,
+						result.pv.move[i] % BOARD_SIZE );
+				} /* for */
+
+				if( pondering  &&  player->opponent->type == PT_HUMAN ) {
+					ponder_start( &ponder, searches, num_threads, player,
+						&result, max_ply, movetime );
+				} /* if */
+			} /* if */
 		} /* if */
 
 		printf( "\nEffect of move == %d\n", effect );
@@ -462,20 +5685,19 @@ unsigned int main( void )
 		} /* if */
 
 		printf( "X: %d;  O: %d\n", x_data.count, o_data.count );
-		draw_board();
+		draw_board( &x_data );
 
 		player = player->opponent;
 	} while( x_data.count > 0  &&  o_data.count > 0
 		&&  x_data.count + o_data.count < BOARD_AREA );
 
-	/* Free local heap */
+	ponder_finish( &ponder, NULL, &result );
 
-	for( i = 0; local_heap != NULL; i++ ) {
-		chain_ptr = local_heap->next;
-		free( local_heap );
-		local_heap = chain_ptr;
-	} /* for */
+	if( stats_file != NULL  &&  stats_file != stdout ) {
+		fclose( stats_file );
+	} /* if */
 
-	printf( "%d objects were in application heap\n", i );
+	free( searches );
+	tt_free( &shared_tt );
 	return( 1 /* May be system-dependent */ );
 } /* main() */